@@ -0,0 +1,270 @@
+// Producer-side cost of MoveAggregator::add() with and without a concurrent
+// consumer draining it through take().
+//
+// The paced cases time what a capture thread pays per motion event at
+// realistic mouse rates instead: SenderFlow::push_event with its worker
+// running on a loopback communication_service, against the mutex design it
+// replaced (a mutex aggregator drained by a thread every flush interval).
+// Each event is timed alone between sleeps, so caches are as cold as the
+// pacing leaves them. CPU is process CPU time per event over the run and
+// includes the consumer; for SenderFlow that also covers sending motion
+// frames through the loopback transport, which the baseline does not do.
+#include "bench.h"
+#include "loopback_services.h"
+
+#include "flows/sender/move_aggregator.h"
+#include "flows/sender/sender.h"
+#include "keyboard/input_event.h"
+#include "utils/latency/latency.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bench
+{
+  namespace
+  {
+    constexpr const char* kSuite = "aggregator";
+    constexpr int kAddsPerCall = 1000;
+
+    // The mutex-based aggregator MoveAggregator replaced. Kept as the
+    // regression baseline.
+    struct mutex_aggregator
+    {
+      std::mutex m;
+      int agg_dx{0};
+      int agg_dy{0};
+
+      void add(int dx, int dy)
+      {
+        if (dx == 0 && dy == 0)
+        {
+          return;
+        }
+        std::lock_guard<std::mutex> lock(m);
+        agg_dx += dx;
+        agg_dy += dy;
+      }
+
+      void take(int& dx, int& dy)
+      {
+        std::lock_guard<std::mutex> lock(m);
+        dx = agg_dx;
+        dy = agg_dy;
+        agg_dx = 0;
+        agg_dy = 0;
+      }
+    };
+
+    // Deltas cycle through both signs so borrows between axes are exercised.
+    inline int delta_x(int i) { return (i % 7) - 3; }
+    inline int delta_y(int i) { return 2 - (i % 5); }
+
+    // 'consumer' selects the contention scenario:
+    //   none     - add() only
+    //   spinning - another thread calls take() back to back (worst case)
+    template <typename Aggregator>
+    void run_case(const options& opt, reporter& rep, const std::string& name,
+                  const std::string& consumer)
+    {
+      if (!matches(opt, kSuite, name))
+      {
+        return;
+      }
+      Aggregator agg;
+      std::atomic<bool> stop{false};
+      int64_t taken_x = 0;
+      int64_t taken_y = 0;
+      std::thread drain;
+      if (consumer == "spinning")
+      {
+        drain = std::thread(
+            [&]
+            {
+              while (!stop.load(std::memory_order_relaxed))
+              {
+                int dx = 0, dy = 0;
+                agg.take(dx, dy);
+                taken_x += dx;
+                taken_y += dy;
+              }
+            });
+      }
+
+      int64_t added_x = 0;
+      int64_t added_y = 0;
+      const auto m = measure(opt,
+                             [&]
+                             {
+                               for (int i = 0; i < kAddsPerCall; ++i)
+                               {
+                                 agg.add(delta_x(i), delta_y(i));
+                                 added_x += delta_x(i);
+                                 added_y += delta_y(i);
+                               }
+                             });
+
+      stop.store(true, std::memory_order_relaxed);
+      if (drain.joinable())
+      {
+        drain.join();
+      }
+      int dx = 0, dy = 0;
+      agg.take(dx, dy);
+      taken_x += dx;
+      taken_y += dy;
+
+      rep.add(kSuite, name, consumer, "ns_per_add",
+              m.ns_per_call / kAddsPerCall, "ns");
+      rep.add(kSuite, name, consumer, "lost_delta",
+              static_cast<double>((added_x - taken_x) + (added_y - taken_y)),
+              "count");
+    }
+
+    // The pre-MoveAggregator sender's motion path: capture threads add
+    // under the aggregator's mutex, a thread takes every flush interval.
+    class mutex_sender
+    {
+    public:
+      mutex_sender()
+          : drain_(
+                [this]
+                {
+                  while (running_.load(std::memory_order_relaxed))
+                  {
+                    std::this_thread::sleep_for(
+                        flows::SenderFlow::kMotionFlushInterval);
+                    int dx = 0, dy = 0;
+                    agg_.take(dx, dy);
+                    do_not_optimize(static_cast<uint64_t>(dx + dy));
+                  }
+                })
+      {
+      }
+
+      ~mutex_sender()
+      {
+        running_.store(false, std::memory_order_relaxed);
+        drain_.join();
+      }
+
+      void push_event(const keyboard::InputEvent& ev)
+      {
+        agg_.add(ev.dx, ev.dy);
+      }
+
+    private:
+      mutex_aggregator agg_;
+      std::atomic<bool> running_{true};
+      std::thread drain_;
+    };
+
+    // Pushes motion events to 'sender' at 'rate_hz' for opt.min_time_ms,
+    // timing each push_event() call.
+    template <typename Sender>
+    void run_paced_case(const options& opt, reporter& rep,
+                        const std::string& name, Sender& sender, int rate_hz)
+    {
+      const std::string trace = "paced_" + std::to_string(rate_hz / 1000) +
+                                "khz";
+      const auto interval = std::chrono::nanoseconds(1000000000 / rate_hz);
+      const auto duration = std::chrono::milliseconds(opt.min_time_ms);
+      std::vector<uint64_t> push_ns;
+      push_ns.reserve(static_cast<size_t>(duration / interval + 1));
+
+      keyboard::InputEvent ev{};
+      ev.type = keyboard::InputEvent::Type::Mouse;
+      ev.action = keyboard::InputEvent::Action::Move;
+      const std::clock_t cpu_before = std::clock();
+      const auto start = std::chrono::steady_clock::now();
+      auto next = start;
+      for (int i = 0; next - start < duration; ++i)
+      {
+        std::this_thread::sleep_until(next);
+        next += interval;
+        ev.dx = delta_x(i);
+        ev.dy = delta_y(i);
+        ev.timestamp_ns = utils::latency::now_ns(); // as capture stamps it
+        const uint64_t before = utils::latency::now_ns();
+        sender.push_event(ev);
+        push_ns.push_back(utils::latency::now_ns() - before);
+      }
+      const double cpu_us =
+          1e6 * static_cast<double>(std::clock() - cpu_before) /
+          CLOCKS_PER_SEC;
+
+      const double events = static_cast<double>(push_ns.size());
+      uint64_t total_ns = 0;
+      for (const uint64_t ns : push_ns)
+      {
+        total_ns += ns;
+      }
+      std::sort(push_ns.begin(), push_ns.end());
+      const size_t p99 = static_cast<size_t>(0.99 * (push_ns.size() - 1));
+
+      rep.add(kSuite, name, trace, "ns_per_push",
+              static_cast<double>(total_ns) / events, "ns");
+      rep.add(kSuite, name, trace, "p99_ns_per_push",
+              static_cast<double>(push_ns[p99]), "ns");
+      rep.add(kSuite, name, trace, "cpu_us_per_event", cpu_us / events, "us");
+    }
+
+    constexpr int kPacedRatesHz[] = {1000, 2000, 4000, 8000};
+
+    void run_paced_mutex(const options& opt, reporter& rep)
+    {
+      const std::string name = "mutex_sender";
+      if (!matches(opt, kSuite, name))
+      {
+        return;
+      }
+      for (const int rate : kPacedRatesHz)
+      {
+        mutex_sender sender;
+        run_paced_case(opt, rep, name, sender, rate);
+      }
+    }
+
+    void run_paced_sender_flow(const options& opt, reporter& rep)
+    {
+      const std::string name = "sender_flow";
+      if (!matches(opt, kSuite, name))
+      {
+        return;
+      }
+      for (const int rate : kPacedRatesHz)
+      {
+        loopback_services services(std::chrono::microseconds(0));
+        flows::SenderFlow sender;
+        if (!sender.start())
+        {
+          std::cerr << "[bench] aggregator/" << name
+                    << ": flow did not start, skipped" << std::endl;
+          return;
+        }
+        run_paced_case(opt, rep, name, sender, rate);
+        sender.stop();
+      }
+    }
+  } // namespace
+
+  void run_aggregator_suite(const options& opt, reporter& rep)
+  {
+    for (const char* consumer : {"none", "spinning"})
+    {
+      run_case<mutex_aggregator>(opt, rep, "mutex_aggregator", consumer);
+      run_case<flows::MoveAggregator>(opt, rep, "move_aggregator", consumer);
+    }
+    run_paced_mutex(opt, rep);
+    run_paced_sender_flow(opt, rep);
+  }
+
+} // namespace bench
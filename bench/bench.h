@@ -0,0 +1,97 @@
+// Minimal benchmark harness shared by all keyleport_bench suites
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+  struct options
+  {
+    std::string format = "csv"; // csv | json
+    std::string filter;         // substring match on "suite/case"
+    std::string out;            // output file; stdout when empty
+    int min_time_ms = 200;      // minimum measured time per case
+  };
+
+  // One metric of one case, in long format so suites can report whatever
+  // metrics make sense for them without changing the output schema.
+  struct result
+  {
+    std::string suite;
+    std::string name;
+    std::string trace;
+    std::string metric;
+    double value;
+    std::string unit;
+  };
+
+  class reporter
+  {
+  public:
+    void add(const std::string& suite, const std::string& name,
+             const std::string& trace, const std::string& metric,
+             double value, const std::string& unit);
+
+    void write_csv(std::ostream& os) const;
+    void write_json(std::ostream& os) const;
+
+  private:
+    std::vector<result> results_;
+  };
+
+  struct measurement
+  {
+    uint64_t calls{0};
+    double ns_per_call{0.0};
+    double allocs_per_call{0.0};
+  };
+
+  // Number of heap allocations performed by this process so far.
+  uint64_t allocation_count();
+
+  // Keep a value alive so the optimizer cannot drop the work producing it.
+  void do_not_optimize(uint64_t value);
+
+  bool matches(const options& opt, const std::string& suite,
+               const std::string& name);
+
+  // Call fn() repeatedly (after one warm-up call) until at least
+  // opt.min_time_ms has elapsed and report per-call cost.
+  template <typename F> measurement measure(const options& opt, F&& fn)
+  {
+    using clock = std::chrono::steady_clock;
+    fn(); // warm-up: fills caches, sizes buffers
+
+    measurement m;
+    const auto budget = std::chrono::milliseconds(opt.min_time_ms);
+    const uint64_t allocs_before = allocation_count();
+    const auto start = clock::now();
+    auto elapsed = clock::duration::zero();
+    do
+    {
+      fn();
+      ++m.calls;
+      elapsed = clock::now() - start;
+    } while (elapsed < budget);
+    const uint64_t allocs = allocation_count() - allocs_before;
+
+    const double ns = static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    m.ns_per_call = ns / static_cast<double>(m.calls);
+    m.allocs_per_call =
+        static_cast<double>(allocs) / static_cast<double>(m.calls);
+    return m;
+  }
+
+  // Suites
+  void run_codec_suite(const options& opt, reporter& rep);
+  void run_aggregator_suite(const options& opt, reporter& rep);
+  void run_loss_suite(const options& opt, reporter& rep);
+  void run_transport_suite(const options& opt, reporter& rep);
+  void run_pipeline_suite(const options& opt, reporter& rep);
+
+} // namespace bench
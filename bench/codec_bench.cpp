@@ -0,0 +1,560 @@
+// Encode/decode throughput, wire size and allocation counts for every codec
+// on the input and control paths.
+#include "bench.h"
+#include "traces.h"
+
+#include "keyboard/event_batch.h"
+#include "keyboard/input_event.h"
+#include "keyboard/motion_stream.h"
+#include "keyboard/pressed_state.h"
+#include "networking/p2p/message.h"
+#include "networking/p2p/peer.h"
+#include "services/communication/packages/become_receiver_package.h"
+#include "services/communication/packages/input_batch_package.h"
+#include "services/communication/packages/key_state_package.h"
+#include "services/communication/packages/keyboard_input_package.h"
+#include "services/communication/packages/motion_package.h"
+#include "services/communication/typed_package.h"
+#include "services/discovery/discovery_peer.h"
+#include "utils/event_emitter/event_emitter.h"
+
+#include <cstdint>
+#include <functional>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bench
+{
+  namespace
+  {
+    constexpr const char* kSuite = "codec";
+    constexpr uint64_t kBatchWindowNs = 8 * 1000 * 1000; // sender flush period
+    constexpr size_t kFrameBufferSize = 1500;
+
+    using frames_t = std::vector<std::string>;
+    // Encodes the whole trace; appends frames when 'out' is non-null (only
+    // during the untimed preparation pass). Returns total wire bytes.
+    using encode_fn = std::function<uint64_t(const trace&, frames_t* out)>;
+    // Decodes all frames; returns a checksum of decoded fields.
+    using decode_fn = std::function<uint64_t(const frames_t&)>;
+
+    uint64_t checksum(const keyboard::InputEvent& e)
+    {
+      return static_cast<uint64_t>(e.code) + static_cast<uint32_t>(e.dx) +
+             (static_cast<uint64_t>(static_cast<uint32_t>(e.dy)) << 16) +
+             static_cast<uint64_t>(e.action);
+    }
+
+    const uint8_t* bytes_of(const std::string& s)
+    {
+      return reinterpret_cast<const uint8_t*>(s.data());
+    }
+
+    void store(frames_t* out, const uint8_t* data, size_t n)
+    {
+      if (out)
+      {
+        out->emplace_back(reinterpret_cast<const char*>(data), n);
+      }
+    }
+
+    void store(frames_t* out, const std::string& s)
+    {
+      if (out)
+      {
+        out->push_back(s);
+      }
+    }
+
+    // Groups events into sender-sized windows and packs each window.
+    template <typename Sink>
+    void for_each_batch(const trace& t, Sink&& sink)
+    {
+      keyboard::EventBatchPacker packer(
+          [&sink](const keyboard::EventBatch& b) { sink(b); });
+      uint64_t window_start = 0;
+      for (const auto& e : t.events)
+      {
+        if (!packer.empty() && e.timestamp_ns - window_start >= kBatchWindowNs)
+        {
+          packer.flush();
+        }
+        if (packer.empty())
+        {
+          window_start = e.timestamp_ns;
+        }
+        packer.push(e);
+      }
+      packer.flush();
+    }
+
+    // Sums motion per sender flush window into one frame per window, the
+    // way SenderFlow does; discrete events are not part of the stream.
+    template <typename Sink>
+    void for_each_motion_frame(const trace& t, Sink&& sink)
+    {
+      keyboard::MotionStreamWriter writer;
+      keyboard::MotionDeltas pending{};
+      bool has_pending = false;
+      uint64_t window_start = 0;
+      for (const auto& e : t.events)
+      {
+        if (e.type != keyboard::InputEvent::Type::Mouse ||
+            (e.action != keyboard::InputEvent::Action::Move &&
+             e.action != keyboard::InputEvent::Action::Scroll))
+        {
+          continue;
+        }
+        if (has_pending && e.timestamp_ns - window_start >= kBatchWindowNs)
+        {
+          sink(writer.next(pending));
+          pending = {};
+          has_pending = false;
+        }
+        if (!has_pending)
+        {
+          window_start = e.timestamp_ns;
+        }
+        auto& d = pending[e.action == keyboard::InputEvent::Action::Move
+                              ? keyboard::MotionFrame::Move
+                              : keyboard::MotionFrame::Scroll];
+        d.dx += e.dx;
+        d.dy += e.dy;
+        has_pending = true;
+      }
+      if (has_pending)
+      {
+        sink(writer.next(pending));
+      }
+    }
+
+    // The pre-binary wire format: an event JSON string nested in a JSON
+    // envelope. Kept as the regression baseline.
+    std::string legacy_envelope_encode(const keyboard::InputEvent& e)
+    {
+      const std::string payload = keyboard::InputEventJSONConverter::encode(e);
+      nlohmann::json j{{"__typename", "keyboard_input"}, {"payload", payload}};
+      return j.dump();
+    }
+
+    keyboard::InputEvent legacy_envelope_decode(const std::string& s)
+    {
+      auto j = nlohmann::json::parse(s, nullptr, false);
+      if (!j.is_object() || !j.contains("payload"))
+      {
+        return keyboard::InputEvent{};
+      }
+      return keyboard::InputEventJSONConverter::decode(
+          j.value("payload", std::string{}));
+    }
+
+    void run_trace_case(const options& opt, reporter& rep,
+                        const std::string& name, const trace& t,
+                        const encode_fn& encode, const decode_fn& decode)
+    {
+      if (!matches(opt, kSuite, name))
+      {
+        return;
+      }
+      frames_t frames;
+      const uint64_t bytes = encode(t, &frames);
+      const double events = static_cast<double>(t.events.size());
+
+      const auto enc =
+          measure(opt, [&] { do_not_optimize(encode(t, nullptr)); });
+      const auto dec = measure(opt, [&] { do_not_optimize(decode(frames)); });
+
+      rep.add(kSuite, name, t.name, "encode_ns_per_event",
+              enc.ns_per_call / events, "ns");
+      rep.add(kSuite, name, t.name, "decode_ns_per_event",
+              dec.ns_per_call / events, "ns");
+      rep.add(kSuite, name, t.name, "bytes_per_event",
+              static_cast<double>(bytes) / events, "B");
+      rep.add(kSuite, name, t.name, "frames",
+              static_cast<double>(frames.size()), "count");
+      rep.add(kSuite, name, t.name, "encode_allocs_per_event",
+              enc.allocs_per_call / events, "count");
+      rep.add(kSuite, name, t.name, "decode_allocs_per_event",
+              dec.allocs_per_call / events, "count");
+    }
+
+    template <typename Encode, typename Decode>
+    void run_control_case(const options& opt, reporter& rep,
+                          const std::string& name, Encode&& encode,
+                          Decode&& decode)
+    {
+      if (!matches(opt, kSuite, name))
+      {
+        return;
+      }
+      const std::string wire = encode();
+      const auto enc = measure(opt, [&] { do_not_optimize(encode().size()); });
+      const auto dec = measure(opt, [&] { do_not_optimize(decode(wire)); });
+
+      rep.add(kSuite, name, "control", "encode_ns_per_op", enc.ns_per_call,
+              "ns");
+      rep.add(kSuite, name, "control", "decode_ns_per_op", dec.ns_per_call,
+              "ns");
+      rep.add(kSuite, name, "control", "bytes_per_op",
+              static_cast<double>(wire.size()), "B");
+      rep.add(kSuite, name, "control", "encode_allocs_per_op",
+              enc.allocs_per_call, "count");
+      rep.add(kSuite, name, "control", "decode_allocs_per_op",
+              dec.allocs_per_call, "count");
+    }
+
+    void run_input_cases(const options& opt, reporter& rep, const trace& t)
+    {
+      run_trace_case(
+          opt, rep, "input_event_json", t,
+          [](const trace& tr, frames_t* out)
+          {
+            uint64_t bytes = 0;
+            for (const auto& e : tr.events)
+            {
+              const std::string s =
+                  keyboard::InputEventJSONConverter::encode(e);
+              bytes += s.size();
+              store(out, s);
+            }
+            return bytes;
+          },
+          [](const frames_t& frames)
+          {
+            uint64_t sum = 0;
+            for (const auto& f : frames)
+            {
+              sum += checksum(keyboard::InputEventJSONConverter::decode(f));
+            }
+            return sum;
+          });
+
+      run_trace_case(
+          opt, rep, "input_event_binary", t,
+          [](const trace& tr, frames_t* out)
+          {
+            uint64_t bytes = 0;
+            uint8_t buf[keyboard::InputEventBinaryConverter::kEncodedSize];
+            for (const auto& e : tr.events)
+            {
+              const size_t n = keyboard::InputEventBinaryConverter::encode(
+                  e, buf, sizeof(buf));
+              bytes += n;
+              store(out, buf, n);
+            }
+            return bytes;
+          },
+          [](const frames_t& frames)
+          {
+            uint64_t sum = 0;
+            for (const auto& f : frames)
+            {
+              keyboard::InputEvent e{};
+              keyboard::InputEventBinaryConverter::decode(
+                  reinterpret_cast<const uint8_t*>(f.data()), f.size(), e);
+              sum += checksum(e);
+            }
+            return sum;
+          });
+
+      run_trace_case(
+          opt, rep, "legacy_json_envelope", t,
+          [](const trace& tr, frames_t* out)
+          {
+            uint64_t bytes = 0;
+            for (const auto& e : tr.events)
+            {
+              const std::string s = legacy_envelope_encode(e);
+              bytes += s.size();
+              store(out, s);
+            }
+            return bytes;
+          },
+          [](const frames_t& frames)
+          {
+            uint64_t sum = 0;
+            for (const auto& f : frames)
+            {
+              sum += checksum(legacy_envelope_decode(f));
+            }
+            return sum;
+          });
+
+      run_trace_case(
+          opt, rep, "keyboard_input_package", t,
+          [](const trace& tr, frames_t* out)
+          {
+            uint64_t bytes = 0;
+            for (const auto& e : tr.events)
+            {
+              const std::string s =
+                  services::keyboard_input_package::build(e).encode();
+              bytes += s.size();
+              store(out, s);
+            }
+            return bytes;
+          },
+          [](const frames_t& frames)
+          {
+            uint64_t sum = 0;
+            services::typed_package pkg;
+            services::keyboard_input_package input;
+            for (const auto& f : frames)
+            {
+              if (services::typed_package::decode_view(bytes_of(f), f.size(),
+                                                       pkg) &&
+                  services::keyboard_input_package::is(pkg) &&
+                  services::keyboard_input_package::decode(
+                      pkg.payload_data(), pkg.payload_size(), input))
+              {
+                sum += checksum(input.event);
+              }
+            }
+            return sum;
+          });
+
+      run_trace_case(
+          opt, rep, "event_batch", t,
+          [](const trace& tr, frames_t* out)
+          {
+            uint64_t bytes = 0;
+            uint8_t buf[kFrameBufferSize];
+            for_each_batch(tr,
+                           [&](const keyboard::EventBatch& b)
+                           {
+                             const size_t n = b.encode(buf, sizeof(buf));
+                             bytes += n;
+                             store(out, buf, n);
+                           });
+            return bytes;
+          },
+          [](const frames_t& frames)
+          {
+            uint64_t sum = 0;
+            keyboard::EventBatch batch;
+            for (const auto& f : frames)
+            {
+              keyboard::EventBatch::decode(
+                  reinterpret_cast<const uint8_t*>(f.data()), f.size(), batch);
+              for (const auto& e : batch.events)
+              {
+                sum += checksum(e);
+              }
+            }
+            return sum;
+          });
+
+      run_trace_case(
+          opt, rep, "input_batch_package", t,
+          [](const trace& tr, frames_t* out)
+          {
+            uint64_t bytes = 0;
+            for_each_batch(tr,
+                           [&](const keyboard::EventBatch& b)
+                           {
+                             const std::string s =
+                                 services::input_batch_package::build(b)
+                                     .encode();
+                             bytes += s.size();
+                             store(out, s);
+                           });
+            return bytes;
+          },
+          [](const frames_t& frames)
+          {
+            uint64_t sum = 0;
+            services::typed_package pkg;
+            services::input_batch_package batch;
+            for (const auto& f : frames)
+            {
+              if (!services::typed_package::decode_view(bytes_of(f), f.size(),
+                                                        pkg) ||
+                  !services::input_batch_package::is(pkg) ||
+                  !services::input_batch_package::decode(
+                      pkg.payload_data(), pkg.payload_size(), batch))
+              {
+                continue;
+              }
+              for (const auto& e : batch.batch.events)
+              {
+                sum += checksum(e);
+              }
+            }
+            return sum;
+          });
+
+      run_trace_case(
+          opt, rep, "motion_package", t,
+          [](const trace& tr, frames_t* out)
+          {
+            uint64_t bytes = 0;
+            for_each_motion_frame(
+                tr,
+                [&](const keyboard::MotionFrame& f)
+                {
+                  const std::string s =
+                      services::motion_package::build(f).encode();
+                  bytes += s.size();
+                  store(out, s);
+                });
+            return bytes;
+          },
+          [](const frames_t& frames)
+          {
+            uint64_t sum = 0;
+            keyboard::MotionStreamReader reader;
+            services::motion_package pkg;
+            keyboard::MotionDeltas deltas{};
+            services::typed_package typed;
+            for (const auto& f : frames)
+            {
+              if (!services::typed_package::decode_view(bytes_of(f), f.size(),
+                                                        typed) ||
+                  !services::motion_package::is(typed) ||
+                  !services::motion_package::decode(typed.payload_data(),
+                                                    typed.payload_size(),
+                                                    pkg) ||
+                  !reader.accept(pkg.frame, deltas))
+              {
+                continue;
+              }
+              for (const auto& d : deltas)
+              {
+                sum += static_cast<uint32_t>(d.dx) +
+                       (static_cast<uint64_t>(static_cast<uint32_t>(d.dy))
+                        << 16);
+              }
+            }
+            return sum;
+          });
+    }
+
+    void run_control_cases(const options& opt, reporter& rep)
+    {
+      services::typed_package envelope;
+      envelope.type = services::package_type::keyboard_input;
+      envelope.payload.assign(keyboard::InputEventBinaryConverter::kEncodedSize,
+                              '\x01');
+      run_control_case(
+          opt, rep, "typed_package", [&] { return envelope.encode(); },
+          [](const std::string& s)
+          { return services::typed_package::decode(s).payload.size(); });
+      run_control_case(
+          opt, rep, "typed_package_view", [&] { return envelope.encode(); },
+          [](const std::string& s)
+          {
+            services::typed_package pkg;
+            services::typed_package::decode_view(bytes_of(s), s.size(), pkg);
+            return pkg.payload_size();
+          });
+
+      // One key event from a borrowed datagram to a decoded InputEvent,
+      // through the same emitters the receive thread uses
+      keyboard::InputEvent key{};
+      key.type = keyboard::InputEvent::Type::Key;
+      key.action = keyboard::InputEvent::Action::Down;
+      key.code = 26;
+      utils::event_emitter<p2p::message> on_message;
+      utils::event_emitter<services::typed_package> on_package;
+      uint64_t received = 0;
+      on_message.subscribe(
+          [&](const p2p::message& msg)
+          {
+            services::typed_package pkg;
+            if (services::typed_package::decode_view(
+                    msg.get_payload_data(), msg.get_payload_size(), pkg))
+            {
+              pkg.meta.set_from(msg.get_from());
+              on_package.emit(pkg);
+            }
+          });
+      on_package.subscribe(
+          [&](const services::typed_package& pkg)
+          {
+            services::keyboard_input_package input;
+            if (services::keyboard_input_package::decode(
+                    pkg.payload_data(), pkg.payload_size(), input))
+            {
+              received += checksum(input.event);
+            }
+          });
+      const p2p::peer from{"192.168.1.20"};
+      run_control_case(
+          opt, rep, "receive_path",
+          [&] { return services::keyboard_input_package::build(key).encode(); },
+          [&](const std::string& s)
+          {
+            p2p::message msg;
+            msg.set_from(from);
+            msg.set_payload_view(bytes_of(s), s.size());
+            on_message.emit(msg);
+            return received;
+          });
+
+      services::discovery_peer peer;
+      peer.device_id = 0x5A17C0DE2B9E4F01ull;
+      peer.device_name = "MacBookPro18,3";
+      peer.platform = services::discovery_platform::macos;
+      peer.state = services::discovery_peer_state::idle;
+      peer.config_epoch = 1;
+      run_control_case(
+          opt, rep, "discovery_peer", [&] { return peer.encode(); },
+          [](const std::string& s)
+          { return services::discovery_peer::decode(s).device_name.size(); });
+      // Listener fast path for a known peer whose epoch is unchanged
+      run_control_case(
+          opt, rep, "discovery_beacon_header", [&] { return peer.encode(); },
+          [](const std::string& s)
+          {
+            services::discovery_beacon_header h;
+            services::discovery_peer::decode_header(
+                reinterpret_cast<const uint8_t*>(s.data()), s.size(), h);
+            return h.config_epoch;
+          });
+
+      // Shift+W held while dragging with the left button
+      keyboard::PressedStateSync sync;
+      sync.seq = 0x12345678;
+      for (const auto& held :
+           {std::make_pair(keyboard::InputEvent::Type::Key, 225),
+            std::make_pair(keyboard::InputEvent::Type::Key, 26),
+            std::make_pair(keyboard::InputEvent::Type::Mouse, 1)})
+      {
+        keyboard::InputEvent e{};
+        e.type = held.first;
+        e.action = keyboard::InputEvent::Action::Down;
+        e.code = static_cast<uint16_t>(held.second);
+        sync.state.apply(e);
+      }
+      run_control_case(
+          opt, rep, "key_state_package", [&] { return sync.encode(); },
+          [](const std::string& s)
+          {
+            keyboard::PressedStateSync out;
+            keyboard::PressedStateSync::decode(s, out);
+            return out.seq;
+          });
+
+      services::become_receiver_package become;
+      become.device_id = peer.device_id;
+      run_control_case(
+          opt, rep, "become_receiver_package", [&] { return become.encode(); },
+          [](const std::string& s)
+          {
+            return services::become_receiver_package::decode(s).device_id;
+          });
+    }
+  } // namespace
+
+  void run_codec_suite(const options& opt, reporter& rep)
+  {
+    for (const auto& t : make_all_traces())
+    {
+      run_input_cases(opt, rep, t);
+    }
+    run_control_cases(opt, rep);
+  }
+
+} // namespace bench
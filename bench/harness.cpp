@@ -0,0 +1,116 @@
+#include "bench.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+  std::atomic<uint64_t> g_allocations{0};
+  volatile uint64_t g_sink = 0;
+
+  void* counted_alloc(std::size_t size)
+  {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+    {
+      return p;
+    }
+    throw std::bad_alloc();
+  }
+
+  // JSON strings are written by hand to keep the bench free of dependencies
+  std::string json_escape(const std::string& s)
+  {
+    std::string out;
+    out.reserve(s.size());
+    for (char c : s)
+    {
+      if (c == '"' || c == '\\')
+      {
+        out.push_back('\\');
+      }
+      out.push_back(c);
+    }
+    return out;
+  }
+} // namespace
+
+// Global allocation hooks used for the allocs_per_op metric
+void* operator new(std::size_t size)
+{
+  return counted_alloc(size);
+}
+void* operator new[](std::size_t size)
+{
+  return counted_alloc(size);
+}
+void operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+void operator delete[](void* p) noexcept
+{
+  std::free(p);
+}
+void operator delete(void* p, std::size_t) noexcept
+{
+  std::free(p);
+}
+void operator delete[](void* p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+namespace bench
+{
+  uint64_t allocation_count()
+  {
+    return g_allocations.load(std::memory_order_relaxed);
+  }
+
+  void do_not_optimize(uint64_t value)
+  {
+    g_sink = g_sink + value;
+  }
+
+  bool matches(const options& opt, const std::string& suite,
+               const std::string& name)
+  {
+    return opt.filter.empty() ||
+           (suite + "/" + name).find(opt.filter) != std::string::npos;
+  }
+
+  void reporter::add(const std::string& suite, const std::string& name,
+                     const std::string& trace, const std::string& metric,
+                     double value, const std::string& unit)
+  {
+    results_.push_back(result{suite, name, trace, metric, value, unit});
+  }
+
+  void reporter::write_csv(std::ostream& os) const
+  {
+    os << "suite,case,trace,metric,value,unit\n";
+    for (const auto& r : results_)
+    {
+      os << r.suite << ',' << r.name << ',' << r.trace << ',' << r.metric
+         << ',' << r.value << ',' << r.unit << '\n';
+    }
+  }
+
+  void reporter::write_json(std::ostream& os) const
+  {
+    os << "[\n";
+    for (size_t i = 0; i < results_.size(); ++i)
+    {
+      const auto& r = results_[i];
+      os << "  {\"suite\":\"" << json_escape(r.suite) << "\",\"case\":\""
+         << json_escape(r.name) << "\",\"trace\":\"" << json_escape(r.trace)
+         << "\",\"metric\":\"" << json_escape(r.metric)
+         << "\",\"value\":" << r.value << ",\"unit\":\""
+         << json_escape(r.unit) << "\"}"
+         << (i + 1 < results_.size() ? ",\n" : "\n");
+    }
+    os << "]\n";
+  }
+} // namespace bench
@@ -0,0 +1,61 @@
+// In-process services for suites that run SenderFlow and ReceiverFlow
+#pragma once
+
+#include "networking/p2p/peer.h"
+#include "networking/p2p/transport.h"
+#include "services/communication/communication_service.h"
+#include "services/service_locator.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+namespace bench
+{
+  // A communication_service on the loopback transport, pinned and
+  // registered with the service locator for as long as this lives, so the
+  // flows find it in start(). A thread ticks its update() the way the
+  // services thread would, which drives ReceiverFlow's timeouts. Stop the
+  // flows before this goes away.
+  class loopback_services
+  {
+  public:
+    explicit loopback_services(std::chrono::microseconds latency)
+        : communication_(std::make_shared<services::communication_service>(
+              p2p::transport_kind::loopback, latency))
+    {
+      communication_->init();
+      communication_->pin_connection(p2p::peer{"127.0.0.1"});
+      services::service_locator::instance().repository.add_service(
+          communication_);
+      ticker_ = std::thread(
+          [this]
+          {
+            while (running_.load())
+            {
+              communication_->update();
+              std::this_thread::sleep_for(communication_->tick_interval());
+            }
+          });
+    }
+
+    ~loopback_services()
+    {
+      running_.store(false);
+      ticker_.join();
+      services::service_locator::instance().repository.remove_service(
+          communication_);
+      communication_->cleanup();
+    }
+
+    loopback_services(const loopback_services&) = delete;
+    loopback_services& operator=(const loopback_services&) = delete;
+
+  private:
+    std::shared_ptr<services::communication_service> communication_;
+    std::atomic<bool> running_{true};
+    std::thread ticker_;
+  };
+
+} // namespace bench
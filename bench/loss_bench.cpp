@@ -0,0 +1,166 @@
+// Key delivery latency under simulated packet loss: ENet-reliable only
+// versus reliable plus redundant unreliable copies.
+//
+// This is a discrete-event model, not a socket test. Each key event of the
+// typing trace is sent at its trace time over a link with a fixed one-way
+// delay plus uniform jitter and independent loss. The reliable path follows
+// ENet: a lost attempt is retried after rtt + 4 * rtt variance, doubling
+// every retry, and the channel delivers in order. Redundant mode adds the
+// given number of unreliable copies, the first at send time and the rest
+// 'spacing' apart; the receiver applies each event on its first copy, still
+// in seq order. Latency is receiver apply time minus sender send time.
+// ReceiverFlow's reorder give-up is not modelled, so the redundant tails are
+// upper bounds.
+#include "bench.h"
+#include "traces.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+  namespace
+  {
+    constexpr const char* kSuite = "loss";
+    constexpr int kRuns = 200; // trace replays per case, each with new loss
+    constexpr uint32_t kSeed = 0x10557u;
+
+    struct link_model
+    {
+      double loss;
+      double one_way_ms;
+      double jitter_ms;
+      double rtt_var_ms; // ENet roundTripTimeVariance on a settled link
+    };
+
+    // Mirrors SenderFlow's redundant key delivery settings
+    struct delivery_mode
+    {
+      const char* name;
+      int copies; // unreliable copies; 0 = reliable only
+      double spacing_ms;
+    };
+
+    class link
+    {
+    public:
+      link(const link_model& model, uint32_t seed)
+          : model_(model), rng_(seed), lost_(model.loss),
+            jitter_(0.0, model.jitter_ms)
+      {
+      }
+
+      // Arrival time of a datagram sent at 't', or a negative value if lost
+      double send(double t)
+      {
+        if (lost_(rng_))
+        {
+          return -1.0;
+        }
+        return t + model_.one_way_ms + jitter_(rng_);
+      }
+
+      // Arrival time of an ENet reliable send issued at 't'
+      double send_reliable(double t)
+      {
+        double timeout = 2.0 * model_.one_way_ms + 4.0 * model_.rtt_var_ms;
+        for (;;)
+        {
+          const double arrival = send(t);
+          if (arrival >= 0.0)
+          {
+            return arrival;
+          }
+          t += timeout;
+          timeout *= 2.0;
+        }
+      }
+
+    private:
+      link_model model_;
+      std::mt19937 rng_;
+      std::bernoulli_distribution lost_;
+      std::uniform_real_distribution<double> jitter_;
+    };
+
+    double percentile(std::vector<double>& sorted, double q)
+    {
+      const size_t i = static_cast<size_t>(q * (sorted.size() - 1));
+      return sorted[i];
+    }
+
+    void run_case(const options& opt, reporter& rep, const trace& t,
+                  const link_model& model, const delivery_mode& mode)
+    {
+      const std::string trace_name =
+          t.name + "_loss" + std::to_string(static_cast<int>(model.loss * 100));
+      if (!matches(opt, kSuite, mode.name))
+      {
+        return;
+      }
+
+      std::vector<double> latencies;
+      latencies.reserve(t.events.size() * kRuns);
+      for (int run = 0; run < kRuns; ++run)
+      {
+        link net(model, kSeed + static_cast<uint32_t>(run));
+        double reliable_delivered = 0.0; // in-order ENet channel
+        double applied = 0.0;            // in-order receiver
+        for (const auto& e : t.events)
+        {
+          const double sent = static_cast<double>(e.timestamp_ns) / 1e6;
+          double first = std::numeric_limits<double>::max();
+          for (int c = 0; c < mode.copies; ++c)
+          {
+            const double arrival = net.send(sent + c * mode.spacing_ms);
+            if (arrival >= 0.0)
+            {
+              first = std::min(first, arrival);
+            }
+          }
+          reliable_delivered =
+              std::max(reliable_delivered, net.send_reliable(sent));
+          first = std::min(first, reliable_delivered);
+          applied = std::max(applied, first);
+          latencies.push_back(applied - sent);
+        }
+      }
+
+      std::sort(latencies.begin(), latencies.end());
+      rep.add(kSuite, mode.name, trace_name, "p50_ms",
+              percentile(latencies, 0.50), "ms");
+      rep.add(kSuite, mode.name, trace_name, "p99_ms",
+              percentile(latencies, 0.99), "ms");
+      rep.add(kSuite, mode.name, trace_name, "p999_ms",
+              percentile(latencies, 0.999), "ms");
+      rep.add(kSuite, mode.name, trace_name, "max_ms", latencies.back(),
+              "ms");
+      rep.add(kSuite, mode.name, trace_name, "datagrams_per_event",
+              1.0 + mode.copies, "count");
+    }
+  } // namespace
+
+  void run_loss_suite(const options& opt, reporter& rep)
+  {
+    // Home Wi-Fi: ~3 ms one way, a few ms of jitter
+    const link_model links[] = {{0.01, 3.0, 2.0, 1.5},
+                                {0.05, 3.0, 2.0, 1.5},
+                                {0.10, 3.0, 2.0, 1.5}};
+    const delivery_mode modes[] = {{"reliable", 0, 0.0},
+                                   {"redundant_x2", 2, 3.0},
+                                   {"redundant_x3", 3, 3.0}};
+    const trace t = make_typing_burst_trace();
+    for (const auto& model : links)
+    {
+      for (const auto& mode : modes)
+      {
+        run_case(opt, rep, t, model, mode);
+      }
+    }
+  }
+
+} // namespace bench
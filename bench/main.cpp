@@ -0,0 +1,94 @@
+// keyleport_bench: codec, pipeline and transport benchmarks.
+//
+// Usage: keyleport_bench [--format csv|json] [--filter <suite/case>]
+//                        [--out <file>] [--min-time-ms <ms>]
+#include "bench.h"
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace
+{
+  void print_usage(const char* program_name)
+  {
+    std::cout << "Usage: " << program_name
+              << " [--format csv|json] [--filter <suite/case>] [--out <file>]"
+                 " [--min-time-ms <ms>]"
+              << std::endl;
+  }
+
+  bool parse(int argc, char* argv[], bench::options& opt)
+  {
+    for (int i = 1; i < argc; ++i)
+    {
+      const std::string arg = argv[i];
+      if (arg == "--format" && i + 1 < argc)
+      {
+        opt.format = argv[++i];
+      }
+      else if (arg == "--filter" && i + 1 < argc)
+      {
+        opt.filter = argv[++i];
+      }
+      else if (arg == "--out" && i + 1 < argc)
+      {
+        opt.out = argv[++i];
+      }
+      else if (arg == "--min-time-ms" && i + 1 < argc)
+      {
+        try
+        {
+          opt.min_time_ms = std::stoi(argv[++i]);
+        }
+        catch (...)
+        {
+          return false;
+        }
+      }
+      else
+      {
+        return false;
+      }
+    }
+    return opt.format == "csv" || opt.format == "json";
+  }
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  bench::options opt;
+  if (!parse(argc, argv, opt))
+  {
+    print_usage(argv[0]);
+    return 1;
+  }
+
+  bench::reporter rep;
+  bench::run_codec_suite(opt, rep);
+  bench::run_aggregator_suite(opt, rep);
+  bench::run_loss_suite(opt, rep);
+  bench::run_transport_suite(opt, rep);
+  bench::run_pipeline_suite(opt, rep);
+
+  std::ofstream file;
+  if (!opt.out.empty())
+  {
+    file.open(opt.out);
+    if (!file)
+    {
+      std::cerr << "[bench] Cannot open " << opt.out << std::endl;
+      return 1;
+    }
+  }
+  std::ostream& os = opt.out.empty() ? std::cout : file;
+  if (opt.format == "json")
+  {
+    rep.write_json(os);
+  }
+  else
+  {
+    rep.write_csv(os);
+  }
+  return 0;
+}
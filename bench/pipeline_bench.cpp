@@ -0,0 +1,220 @@
+// The whole input pipeline in one process: SenderFlow -> communication_service
+// on the loopback transport -> ReceiverFlow -> a counting Emitter that
+// stands in for the platform one.
+//
+// Each case replays the first kReplayWindow of a trace at its own pace
+// through SenderFlow::push_event, stamping every event at push time as
+// capture would, over a loopback link with the case's one-way latency.
+// Key latency is Emitter::emit time minus that stamp, for key and button
+// events. lost_delta is motion pushed minus motion emitted, in counts; it
+// should be 0 on a link that loses nothing. CPU is process CPU time over
+// the replay and drain divided by the events pushed, and covers every
+// thread: sender worker, loopback delivery and receiver.
+#include "bench.h"
+#include "loopback_services.h"
+#include "traces.h"
+
+#include "flows/receiver/receiver.h"
+#include "flows/sender/sender.h"
+#include "keyboard/keyboard.h"
+#include "utils/latency/latency.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bench
+{
+  namespace
+  {
+    constexpr const char* kSuite = "pipeline";
+    constexpr auto kReplayWindow = std::chrono::seconds(1);
+    // Covers the sender's motion flush interval and the link latency
+    constexpr auto kDrainTime = std::chrono::milliseconds(100);
+
+    // What the counting emitter saw; reset per case
+    struct emit_log
+    {
+      std::mutex m;
+      std::vector<uint64_t> key_latency_ns;
+      int64_t keys = 0;
+      int64_t dx = 0;
+      int64_t dy = 0;
+
+      void reset()
+      {
+        std::lock_guard<std::mutex> lock(m);
+        key_latency_ns.clear();
+        keys = 0;
+        dx = 0;
+        dy = 0;
+      }
+    };
+
+    emit_log emitted;
+
+    class counting_emitter : public keyboard::Emitter
+    {
+    public:
+      int emit(const keyboard::InputEvent& ev) override
+      {
+        const uint64_t now = utils::latency::now_ns();
+        std::lock_guard<std::mutex> lock(emitted.m);
+        if (ev.action == keyboard::InputEvent::Action::Move ||
+            ev.action == keyboard::InputEvent::Action::Scroll)
+        {
+          emitted.dx += ev.dx;
+          emitted.dy += ev.dy;
+          return 0;
+        }
+        ++emitted.keys;
+        // Events the receiver synthesizes carry no capture stamp
+        if (ev.timestamp_ns != 0)
+        {
+          emitted.key_latency_ns.push_back(now - ev.timestamp_ns);
+        }
+        return 0;
+      }
+    };
+
+    class counting_keyboard : public keyboard::Keyboard
+    {
+    public:
+      std::unique_ptr<keyboard::Emitter> createEmitter() override
+      {
+        return std::make_unique<counting_emitter>();
+      }
+    };
+
+    double percentile_us(const std::vector<uint64_t>& sorted, double q)
+    {
+      if (sorted.empty())
+      {
+        return 0.0;
+      }
+      const size_t i = static_cast<size_t>(q * (sorted.size() - 1));
+      return static_cast<double>(sorted[i]) / 1000.0;
+    }
+
+    void run_case(const options& opt, reporter& rep, const trace& t,
+                  std::chrono::microseconds latency)
+    {
+      const std::string name =
+          "loopback_" + std::to_string(latency.count()) + "us";
+      if (!matches(opt, kSuite, name) || t.events.empty())
+      {
+        return;
+      }
+      emitted.reset();
+      loopback_services services(latency);
+      flows::ReceiverFlow receiver;
+      flows::SenderFlow sender;
+      if (!receiver.start() || !sender.start())
+      {
+        std::cerr << "[bench] pipeline/" << name << ": flows did not start, "
+                  << "skipped" << std::endl;
+        return;
+      }
+
+      const std::clock_t cpu_before = std::clock();
+      const uint64_t trace_start = t.events.front().timestamp_ns;
+      const uint64_t window_ns = static_cast<uint64_t>(
+          std::chrono::nanoseconds(kReplayWindow).count());
+      const auto start = std::chrono::steady_clock::now();
+      int64_t pushed = 0;
+      int64_t keys = 0;
+      int64_t dx = 0;
+      int64_t dy = 0;
+      for (keyboard::InputEvent ev : t.events)
+      {
+        const uint64_t offset = ev.timestamp_ns - trace_start;
+        if (offset >= window_ns)
+        {
+          break;
+        }
+        std::this_thread::sleep_until(start +
+                                      std::chrono::nanoseconds(offset));
+        ev.timestamp_ns = utils::latency::now_ns();
+        sender.push_event(ev);
+        ++pushed;
+        if (ev.action == keyboard::InputEvent::Action::Move ||
+            ev.action == keyboard::InputEvent::Action::Scroll)
+        {
+          dx += ev.dx;
+          dy += ev.dy;
+        }
+        else
+        {
+          ++keys;
+        }
+      }
+      std::this_thread::sleep_for(latency + kDrainTime);
+      const double cpu_us =
+          1e6 * static_cast<double>(std::clock() - cpu_before) /
+          CLOCKS_PER_SEC;
+      sender.stop();
+      receiver.stop();
+
+      std::vector<uint64_t> samples;
+      int64_t keys_emitted = 0;
+      int64_t lost = 0;
+      {
+        std::lock_guard<std::mutex> lock(emitted.m);
+        samples.swap(emitted.key_latency_ns);
+        keys_emitted = emitted.keys;
+        lost = std::llabs(dx - emitted.dx) + std::llabs(dy - emitted.dy);
+      }
+      std::sort(samples.begin(), samples.end());
+
+      rep.add(kSuite, name, t.name, "events", static_cast<double>(pushed),
+              "count");
+      rep.add(kSuite, name, t.name, "cpu_us_per_event",
+              cpu_us / static_cast<double>(pushed), "us");
+      rep.add(kSuite, name, t.name, "lost_delta", static_cast<double>(lost),
+              "count");
+      if (keys == 0)
+      {
+        return; // motion only
+      }
+      rep.add(kSuite, name, t.name, "keys_delivered_ratio",
+              static_cast<double>(keys_emitted) / static_cast<double>(keys),
+              "ratio");
+      rep.add(kSuite, name, t.name, "key_p50_us",
+              percentile_us(samples, 0.50), "us");
+      rep.add(kSuite, name, t.name, "key_p99_us",
+              percentile_us(samples, 0.99), "us");
+    }
+  } // namespace
+
+  void run_pipeline_suite(const options& opt, reporter& rep)
+  {
+    const std::chrono::microseconds latencies[] = {
+        std::chrono::microseconds(0), std::chrono::microseconds(1000)};
+    for (const auto& t : make_all_traces())
+    {
+      for (const auto latency : latencies)
+      {
+        run_case(opt, rep, t, latency);
+      }
+    }
+  }
+
+} // namespace bench
+
+namespace keyboard
+{
+  // ReceiverFlow injects through this instead of the platform keyboard,
+  // which keyleport_bench does not link.
+  std::unique_ptr<Keyboard> make_keyboard()
+  {
+    return std::make_unique<bench::counting_keyboard>();
+  }
+} // namespace keyboard
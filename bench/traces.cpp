@@ -0,0 +1,159 @@
+#include "traces.h"
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+namespace bench
+{
+  namespace
+  {
+    using keyboard::InputEvent;
+
+    constexpr uint64_t kNsPerUs = 1000;
+    constexpr uint64_t kNsPerMs = 1000 * kNsPerUs;
+    constexpr uint64_t kTraceStartNs = 10 * 1000 * kNsPerMs;
+    constexpr uint32_t kSeed = 0x6b6c7074; // fixed for reproducible traces
+
+    InputEvent make_event(InputEvent::Type type, InputEvent::Action action,
+                          uint16_t code, int32_t dx, int32_t dy, uint64_t ts)
+    {
+      InputEvent e{};
+      e.type = type;
+      e.action = action;
+      e.code = code;
+      e.dx = dx;
+      e.dy = dy;
+      e.timestamp_ns = ts;
+      return e;
+    }
+
+    InputEvent move(int32_t dx, int32_t dy, uint64_t ts)
+    {
+      return make_event(InputEvent::Type::Mouse, InputEvent::Action::Move, 0,
+                        dx, dy, ts);
+    }
+
+    InputEvent key(uint16_t scancode, bool down, uint64_t ts)
+    {
+      const auto action =
+          down ? InputEvent::Action::Down : InputEvent::Action::Up;
+      return make_event(InputEvent::Type::Key, action, scancode, 0, 0, ts);
+    }
+  } // namespace
+
+  trace make_mouse_8khz_trace()
+  {
+    constexpr int kEvents = 8000;
+    constexpr uint64_t kPeriodNs = 125 * kNsPerUs;
+
+    trace t{"mouse_8khz", {}};
+    t.events.reserve(kEvents);
+    std::mt19937 rng(kSeed);
+    std::uniform_int_distribution<int> jitter(-1, 1);
+    uint64_t ts = kTraceStartNs;
+    for (int i = 0; i < kEvents; ++i)
+    {
+      // Sweeping arcs: a few counts per report, as a high-DPI sensor produces
+      const double phase = static_cast<double>(i) / 400.0;
+      const int32_t dx =
+          static_cast<int32_t>(std::lround(3.0 * std::cos(phase))) +
+          jitter(rng);
+      const int32_t dy =
+          static_cast<int32_t>(std::lround(2.0 * std::sin(phase * 1.3))) +
+          jitter(rng);
+      t.events.push_back(move(dx, dy, ts));
+      ts += kPeriodNs;
+    }
+    return t;
+  }
+
+  trace make_typing_burst_trace()
+  {
+    constexpr int kWords = 60;
+    constexpr uint16_t kScancodeA = 4;
+    constexpr uint16_t kScancodeSpace = 44;
+    constexpr uint16_t kScancodeLShift = 225;
+
+    trace t{"typing_burst", {}};
+    std::mt19937 rng(kSeed);
+    std::uniform_int_distribution<int> letter(0, 25);
+    std::uniform_int_distribution<int> word_len(2, 9);
+    std::uniform_int_distribution<int> gap_ms(40, 140);
+    std::uniform_int_distribution<int> hold_ms(25, 90);
+    std::uniform_int_distribution<int> pause_ms(150, 600);
+    uint64_t ts = kTraceStartNs;
+    for (int w = 0; w < kWords; ++w)
+    {
+      const bool capitalize = (w % 7) == 0;
+      const int len = word_len(rng);
+      for (int c = 0; c < len; ++c)
+      {
+        const uint16_t sc = static_cast<uint16_t>(kScancodeA + letter(rng));
+        const bool chord = capitalize && c == 0;
+        if (chord)
+        {
+          t.events.push_back(key(kScancodeLShift, true, ts));
+          ts += 20 * kNsPerMs;
+        }
+        t.events.push_back(key(sc, true, ts));
+        ts += static_cast<uint64_t>(hold_ms(rng)) * kNsPerMs;
+        t.events.push_back(key(sc, false, ts));
+        if (chord)
+        {
+          ts += 10 * kNsPerMs;
+          t.events.push_back(key(kScancodeLShift, false, ts));
+        }
+        ts += static_cast<uint64_t>(gap_ms(rng)) * kNsPerMs;
+      }
+      t.events.push_back(key(kScancodeSpace, true, ts));
+      ts += 40 * kNsPerMs;
+      t.events.push_back(key(kScancodeSpace, false, ts));
+      ts += static_cast<uint64_t>(pause_ms(rng)) * kNsPerMs;
+    }
+    return t;
+  }
+
+  trace make_drag_scroll_trace()
+  {
+    constexpr int kCycles = 20;
+    constexpr int kMovesPerDrag = 250;
+    constexpr int kScrollEvery = 16; // one wheel notch per 16 ms of motion
+    constexpr uint16_t kLeftButton = 1;
+
+    trace t{"drag_scroll", {}};
+    std::mt19937 rng(kSeed);
+    std::uniform_int_distribution<int> delta(-6, 6);
+    uint64_t ts = kTraceStartNs;
+    for (int c = 0; c < kCycles; ++c)
+    {
+      t.events.push_back(make_event(InputEvent::Type::Mouse,
+                                    InputEvent::Action::Down, kLeftButton, 0,
+                                    0, ts));
+      for (int i = 0; i < kMovesPerDrag; ++i)
+      {
+        ts += kNsPerMs;
+        t.events.push_back(move(delta(rng), delta(rng), ts));
+        if (i % kScrollEvery == 0)
+        {
+          t.events.push_back(make_event(InputEvent::Type::Mouse,
+                                        InputEvent::Action::Scroll, 0, 0,
+                                        (i / kScrollEvery) % 2 ? 1 : -1, ts));
+        }
+      }
+      ts += 5 * kNsPerMs;
+      t.events.push_back(make_event(InputEvent::Type::Mouse,
+                                    InputEvent::Action::Up, kLeftButton, 0, 0,
+                                    ts));
+      ts += 300 * kNsPerMs;
+    }
+    return t;
+  }
+
+  std::vector<trace> make_all_traces()
+  {
+    return {make_mouse_8khz_trace(), make_typing_burst_trace(),
+            make_drag_scroll_trace()};
+  }
+
+} // namespace bench
@@ -0,0 +1,27 @@
+// Synthetic but realistic input traces used by the benchmark suites
+#pragma once
+
+#include "keyboard/input_event.h"
+
+#include <string>
+#include <vector>
+
+namespace bench
+{
+  struct trace
+  {
+    std::string name;
+    std::vector<keyboard::InputEvent> events;
+  };
+
+  // One second of motion from an 8 kHz gaming mouse: small deltas every
+  // 125 us.
+  trace make_mouse_8khz_trace();
+  // Bursty typing at ~100 wpm with modifier chords and pauses between words.
+  trace make_typing_burst_trace();
+  // Press-drag-release cycles at 1 kHz motion interleaved with wheel scrolls.
+  trace make_drag_scroll_trace();
+
+  std::vector<trace> make_all_traces();
+
+} // namespace bench
@@ -0,0 +1,344 @@
+// p2p transports compared: ENet and raw UDP over the loopback interface,
+// plus the in-process loopback transport as a no-socket baseline.
+//
+// Each case sends kMessages messages at 1 kHz. Socket cases go through a
+// relay that forwards datagrams both ways and counts their bytes, so wire
+// bytes include handshakes, acks and pings. Every payload carries its send
+// time; latency is receiver on_message time minus send time (one clock,
+// one process). CPU is process CPU time over the whole run, relay
+// included, divided by the message count; the relay costs the same per
+// datagram for both socket transports, so compare the difference rather
+// than the absolute value.
+#include "bench.h"
+
+#include "networking/p2p/transport.h"
+#include "utils/byte_order/byte_order.h"
+#include "utils/latency/latency.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <enet/enet.h>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace bench
+{
+  namespace
+  {
+    constexpr const char* kSuite = "transport";
+    constexpr int kMessages = 1000;
+    constexpr auto kSendInterval = std::chrono::microseconds(1000);
+    // Roughly one encoded key or motion event
+    constexpr size_t kPayloadSize = 24;
+    constexpr enet_uint16 kRelayPort = 48731;
+    constexpr enet_uint16 kServerPort = 48732;
+
+    // Forwards datagrams between one client and the server on loopback,
+    // counting UDP payload bytes in both directions.
+    class relay
+    {
+    public:
+      relay()
+      {
+        socket_ = enet_socket_create(ENET_SOCKET_TYPE_DATAGRAM);
+        ENetAddress address{};
+        address.host = ENET_HOST_ANY;
+        address.port = kRelayPort;
+        if (socket_ == ENET_SOCKET_NULL ||
+            enet_socket_bind(socket_, &address) < 0)
+        {
+          return;
+        }
+        enet_socket_set_option(socket_, ENET_SOCKOPT_NONBLOCK, 1);
+        enet_address_set_host_ip(&server_, "127.0.0.1");
+        server_.port = kServerPort;
+        running_.store(true);
+        thread_ = std::thread(&relay::loop, this);
+      }
+
+      ~relay()
+      {
+        running_.store(false);
+        if (thread_.joinable())
+        {
+          thread_.join();
+        }
+        if (socket_ != ENET_SOCKET_NULL)
+        {
+          enet_socket_destroy(socket_);
+        }
+      }
+
+      bool ok() const { return running_.load(); }
+      uint64_t bytes() const { return bytes_.load(); }
+      uint64_t datagrams() const { return datagrams_.load(); }
+
+    private:
+      ENetSocket socket_{ENET_SOCKET_NULL};
+      ENetAddress server_{};
+      ENetAddress client_{};
+      std::array<uint8_t, 4096> buf_{};
+      std::atomic<uint64_t> bytes_{0};
+      std::atomic<uint64_t> datagrams_{0};
+      std::atomic<bool> running_{false};
+      std::thread thread_;
+
+      void loop()
+      {
+        while (running_.load())
+        {
+          enet_uint32 condition = ENET_SOCKET_WAIT_RECEIVE;
+          if (enet_socket_wait(socket_, &condition, 50) < 0 ||
+              !(condition & ENET_SOCKET_WAIT_RECEIVE))
+          {
+            continue;
+          }
+          for (;;)
+          {
+            ENetAddress from{};
+            ENetBuffer buffer;
+            buffer.data = buf_.data();
+            buffer.dataLength = buf_.size();
+            const int n = enet_socket_receive(socket_, &from, &buffer, 1);
+            if (n <= 0)
+            {
+              break;
+            }
+            const bool from_server =
+                from.host == server_.host && from.port == server_.port;
+            if (!from_server)
+            {
+              client_ = from;
+            }
+            buffer.dataLength = static_cast<size_t>(n);
+            enet_socket_send(socket_, from_server ? &client_ : &server_,
+                             &buffer, 1);
+            bytes_.fetch_add(static_cast<uint64_t>(n));
+            datagrams_.fetch_add(1);
+          }
+        }
+      }
+    };
+
+    // Collects one-way latencies from on_message; receive thread only.
+    struct latency_sink
+    {
+      std::mutex m;
+      std::vector<uint64_t> samples_ns;
+      std::atomic<int> received{0};
+
+      void on_message(const p2p::message& msg)
+      {
+        if (msg.get_payload_size() != kPayloadSize)
+        {
+          return;
+        }
+        const uint64_t sent_ns =
+            utils::byte_order::get_u64(msg.get_payload_data());
+        std::lock_guard<std::mutex> lock(m);
+        samples_ns.push_back(utils::latency::now_ns() - sent_ns);
+        received.fetch_add(1);
+      }
+    };
+
+    p2p::message make_message(uint64_t index)
+    {
+      std::string payload(kPayloadSize, '\0');
+      auto* out = reinterpret_cast<uint8_t*>(&payload[0]);
+      const uint64_t now = utils::latency::now_ns();
+      utils::byte_order::put_u64(out, now);
+      utils::byte_order::put_u64(out + 8, index);
+      p2p::message msg;
+      msg.set_payload(std::move(payload));
+      msg.set_timestamp_ns(now);
+      return msg;
+    }
+
+    p2p::udp_client_configuration client_config()
+    {
+      p2p::udp_client_configuration config;
+      config.set_peer(p2p::peer{"127.0.0.1"});
+      config.set_port(kRelayPort);
+      return config;
+    }
+
+    p2p::udp_server_configuration server_config()
+    {
+      p2p::udp_server_configuration config;
+      config.set_port(kServerPort);
+      return config;
+    }
+
+    double percentile_us(std::vector<uint64_t>& sorted, double q)
+    {
+      if (sorted.empty())
+      {
+        return 0.0;
+      }
+      const size_t i = static_cast<size_t>(q * (sorted.size() - 1));
+      return static_cast<double>(sorted[i]) / 1000.0;
+    }
+
+    // Sends kMessages through 'sender' and reports. Wire metrics need the
+    // relay and are left out without one.
+    void run_case(reporter& rep, const char* name, const char* trace_name,
+                  p2p::traffic_class cls, p2p::transport& sender,
+                  const relay* r, latency_sink& sink)
+    {
+      const uint64_t bytes_before = r ? r->bytes() : 0;
+      const uint64_t datagrams_before = r ? r->datagrams() : 0;
+      const std::clock_t cpu_before = std::clock();
+
+      auto next = std::chrono::steady_clock::now();
+      for (int i = 0; i < kMessages; ++i)
+      {
+        sender.send(make_message(static_cast<uint64_t>(i)), cls);
+        next += kSendInterval;
+        std::this_thread::sleep_until(next);
+      }
+      // Let the tail arrive, and acks for it
+      const auto deadline =
+          std::chrono::steady_clock::now() + std::chrono::seconds(1);
+      while (sink.received.load() < kMessages &&
+             std::chrono::steady_clock::now() < deadline)
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+      const double cpu_us =
+          1e6 * static_cast<double>(std::clock() - cpu_before) /
+          CLOCKS_PER_SEC;
+
+      std::vector<uint64_t> samples;
+      {
+        std::lock_guard<std::mutex> lock(sink.m);
+        samples.swap(sink.samples_ns);
+      }
+      std::sort(samples.begin(), samples.end());
+      const double delivered = static_cast<double>(samples.size());
+
+      rep.add(kSuite, name, trace_name, "cpu_us_per_event",
+              cpu_us / kMessages, "us");
+      if (r)
+      {
+        const double bytes = static_cast<double>(r->bytes() - bytes_before);
+        const double datagrams =
+            static_cast<double>(r->datagrams() - datagrams_before);
+        rep.add(kSuite, name, trace_name, "wire_bytes_per_event",
+                bytes / kMessages, "bytes");
+        rep.add(kSuite, name, trace_name, "datagrams_per_event",
+                datagrams / kMessages, "count");
+      }
+      rep.add(kSuite, name, trace_name, "delivered_ratio",
+              delivered / kMessages, "ratio");
+      rep.add(kSuite, name, trace_name, "p50_us",
+              percentile_us(samples, 0.50), "us");
+      rep.add(kSuite, name, trace_name, "p99_us",
+              percentile_us(samples, 0.99), "us");
+    }
+
+    // Socket transports: a listening and a connected transport talking
+    // through the relay.
+    void run_socket_case(const options& opt, reporter& rep,
+                         p2p::transport_kind kind, p2p::traffic_class cls,
+                         const char* trace_name)
+    {
+      const char* name = p2p::transport_kind_name(kind);
+      if (!matches(opt, kSuite, name))
+      {
+        return;
+      }
+      relay r;
+      if (!r.ok())
+      {
+        std::cerr << "[bench] transport/" << name
+                  << ": relay port busy, skipped" << std::endl;
+        return;
+      }
+      latency_sink sink;
+      auto receiver = p2p::make_transport(kind);
+      receiver->on_message.subscribe([&sink](const p2p::message& msg)
+                                     { sink.on_message(msg); });
+      receiver->listen(server_config());
+      auto sender = p2p::make_transport(kind);
+      sender->connect(client_config());
+
+      // Connecting may be asynchronous and starts with the first send; the
+      // handshake is not part of the run. The sink ignores the primer.
+      if (sender->state() != p2p::connection_state::connected)
+      {
+        p2p::message primer;
+        primer.set_payload("primer");
+        sender->send(primer, p2p::traffic_class::reliable);
+      }
+      const auto deadline =
+          std::chrono::steady_clock::now() + std::chrono::seconds(2);
+      while (sender->state() != p2p::connection_state::connected &&
+             std::chrono::steady_clock::now() < deadline)
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      }
+      if (sender->state() != p2p::connection_state::connected)
+      {
+        std::cerr << "[bench] transport/" << name
+                  << ": no connection, skipped" << std::endl;
+        return;
+      }
+      run_case(rep, name, trace_name, cls, *sender, &r, sink);
+    }
+
+    // In-process loopback: one transport sends to itself with no latency
+    // added, so what remains is the transport's own overhead.
+    void run_loopback_case(const options& opt, reporter& rep,
+                           p2p::traffic_class cls, const char* trace_name)
+    {
+      const char* name =
+          p2p::transport_kind_name(p2p::transport_kind::loopback);
+      if (!matches(opt, kSuite, name))
+      {
+        return;
+      }
+      latency_sink sink;
+      auto loopback = p2p::make_transport(p2p::transport_kind::loopback);
+      loopback->on_message.subscribe([&sink](const p2p::message& msg)
+                                     { sink.on_message(msg); });
+      loopback->listen(server_config());
+      loopback->connect(client_config());
+      run_case(rep, name, trace_name, cls, *loopback, nullptr, sink);
+    }
+  } // namespace
+
+  void run_transport_suite(const options& opt, reporter& rep)
+  {
+    if (enet_initialize() != 0)
+    {
+      std::cerr << "[bench] transport: ENet init failed, skipped"
+                << std::endl;
+      return;
+    }
+    const struct
+    {
+      p2p::traffic_class cls;
+      const char* trace_name;
+    } traces[] = {{p2p::traffic_class::reliable, "reliable_1khz"},
+                  {p2p::traffic_class::unreliable, "unreliable_1khz"}};
+    for (const auto& t : traces)
+    {
+      run_socket_case(opt, rep, p2p::transport_kind::enet, t.cls,
+                      t.trace_name);
+      run_socket_case(opt, rep, p2p::transport_kind::raw_udp, t.cls,
+                      t.trace_name);
+      run_loopback_case(opt, rep, t.cls, t.trace_name);
+    }
+  }
+
+} // namespace bench
@@ -0,0 +1,455 @@
+#include "receiver.h"
+
+#include "keyboard/input_event.h"
+#include "services/communication/packages/key_state_package.h"
+#include "services/communication/packages/keyboard_input_package.h"
+#include "services/communication/packages/motion_package.h"
+#include "services/service_locator.h"
+#include "utils/latency/latency.h"
+
+#include <iostream>
+
+namespace flows
+{
+
+  ReceiverFlow::~ReceiverFlow()
+  {
+    stop();
+  }
+
+  bool ReceiverFlow::start()
+  {
+    communication_service_ =
+        services::service_locator::instance()
+            .repository.get_service<services::communication_service>();
+
+    if (!communication_service_)
+    {
+      std::cerr << "[receiver] Unable to start: communication_service not found"
+                << std::endl;
+      return false;
+    }
+
+    kb_ = keyboard::make_keyboard();
+    emitter_ = kb_ ? kb_->createEmitter() : nullptr;
+    if (!emitter_)
+    {
+      std::cerr << "[receiver] Unable to start: no input emitter" << std::endl;
+      kb_.reset();
+      communication_service_ = nullptr;
+      return false;
+    }
+
+    motion_reader_ = keyboard::MotionStreamReader();
+    emitted_.clear();
+    held_.clear();
+    fence_timeouts_ = 0;
+    reorder_timeouts_ = 0;
+    duplicate_keys_ = 0;
+    late_keys_ = 0;
+    key_seq_known_ = false;
+    last_heard_ = clock::now();
+    subscription_id_ = communication_service_->on_package.subscribe(
+        [this](const services::typed_package& package)
+        { on_package(package); });
+    update_subscription_id_ =
+        communication_service_->on_update.subscribe([this] { on_update(); });
+
+    std::cout << "[receiver] Subscribed to communication_service with id "
+              << subscription_id_ << std::endl;
+    return true;
+  }
+
+  void ReceiverFlow::stop()
+  {
+    if (!communication_service_)
+    {
+      return;
+    }
+    communication_service_->on_package.unsubscribe(subscription_id_);
+    communication_service_->on_update.unsubscribe(update_subscription_id_);
+    // A callback already dispatched may still be running
+    std::lock_guard<std::mutex> lock(m_);
+    // Never leave keys held on this machine
+    held_.clear();
+    reconcile(keyboard::PressedState{});
+    std::cout << "[receiver] Unsubscribed from communication_service id "
+              << subscription_id_ << std::endl;
+
+    const auto& stats = motion_reader_.stats();
+    std::cout << "[receiver] Motion frames applied=" << stats.applied
+              << " recovered=" << stats.recovered
+              << " stale=" << stats.stale
+              << " fence_timeouts=" << fence_timeouts_ << std::endl;
+    std::cout << "[receiver] Key events duplicate=" << duplicate_keys_
+              << " late=" << late_keys_
+              << " reorder_timeouts=" << reorder_timeouts_ << std::endl;
+
+    communication_service_ = nullptr;
+    subscription_id_ = 0;
+    update_subscription_id_ = 0;
+    emitter_.reset();
+    kb_.reset();
+  }
+
+  void ReceiverFlow::on_package(const services::typed_package& package)
+  {
+    std::lock_guard<std::mutex> lock(m_);
+    if (!emitter_)
+    {
+      return; // stopped
+    }
+    switch (package.type)
+    {
+    case services::keyboard_input_package::type:
+    {
+      services::keyboard_input_package pkg;
+      if (services::keyboard_input_package::decode(
+              package.payload_data(), package.payload_size(), pkg))
+      {
+        apply_key_event(pkg.event, package.meta.get_timestamp_ns());
+      }
+      return;
+    }
+    case services::key_state_package::type:
+      apply_key_sync(package);
+      return;
+    case services::input_batch_package::type:
+    {
+      // Senders before the motion stream shipped motion as event batches
+      if (!services::input_batch_package::decode(package.payload_data(),
+                                                 package.payload_size(),
+                                                 batch_))
+      {
+        return;
+      }
+      for (const auto& ev : batch_.batch.events)
+      {
+        emitter_->emit(ev);
+        emitted_.apply(ev);
+      }
+      break;
+    }
+    case services::motion_package::type:
+      apply_motion(package);
+      break;
+    default:
+      return;
+    }
+    utils::latency::record_since(utils::latency::stage::receive_to_inject,
+                                 package.meta.get_timestamp_ns());
+  }
+
+  void ReceiverFlow::on_update()
+  {
+    std::lock_guard<std::mutex> lock(m_);
+    if (!emitter_)
+    {
+      return;
+    }
+    release_held_events();
+    if (emitted_.empty())
+    {
+      return;
+    }
+    const auto timeout = keyboard::PressedStateSync::kInterval *
+                         keyboard::PressedStateSync::kMissedBeforeRelease;
+    if (clock::now() - last_heard_ < timeout)
+    {
+      return;
+    }
+    std::cerr << "[receiver] No key state from sender for "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(timeout)
+                     .count()
+              << " ms, releasing held keys" << std::endl;
+    reconcile(keyboard::PressedState{});
+  }
+
+  void ReceiverFlow::apply_key_event(const keyboard::InputEvent& ev,
+                                     uint64_t received_ns)
+  {
+    const auto now = clock::now();
+    last_heard_ = now;
+    if (ev.seq != 0)
+    {
+      if (is_new_key_session(ev.seq))
+      {
+        restart_key_session(ev.seq);
+      }
+      else if (key_seq_applied(ev.seq))
+      {
+        ++duplicate_keys_; // another copy
+        return;
+      }
+    }
+
+    // Keep held_ in seq order; unnumbered events queue at the back
+    auto pos = held_.end();
+    if (ev.seq != 0)
+    {
+      for (auto it = held_.begin(); it != held_.end(); ++it)
+      {
+        if (it->event.seq == ev.seq)
+        {
+          ++duplicate_keys_;
+          return;
+        }
+        if (it->event.seq != 0 &&
+            static_cast<int32_t>(ev.seq - it->event.seq) < 0)
+        {
+          pos = it;
+          break;
+        }
+      }
+    }
+    held_.insert(pos, held_event{ev, now, received_ns});
+    release_held_events();
+  }
+
+  void ReceiverFlow::emit_key_event(const keyboard::InputEvent& ev,
+                                    uint64_t received_ns)
+  {
+    // Events from senders without numbering are applied as they come
+    bool late = false;
+    if (ev.seq != 0)
+    {
+      if (key_seq_applied(ev.seq))
+      {
+        ++duplicate_keys_;
+        return;
+      }
+      late = key_event_superseded(ev);
+      mark_key_seq_applied(ev.seq);
+      if (static_cast<int32_t>(ev.seq - next_key_seq_) >= 0)
+      {
+        next_key_seq_ = ev.seq + 1;
+      }
+    }
+    if (late)
+    {
+      apply_late_key_event(ev);
+    }
+    else
+    {
+      if (uint32_t* last = last_code_seq(ev))
+      {
+        *last = ev.seq;
+      }
+      emitter_->emit(ev);
+      emitted_.apply(ev);
+    }
+    utils::latency::record_since(utils::latency::stage::receive_to_inject,
+                                 received_ns);
+  }
+
+  void ReceiverFlow::apply_late_key_event(const keyboard::InputEvent& ev)
+  {
+    ++late_keys_;
+    // A release, or a press that still holds, is already reflected in
+    // emitted_ by the newer event or sync
+    if (ev.action != keyboard::InputEvent::Action::Down ||
+        emitted_.pressed(ev.type, ev.code))
+    {
+      return;
+    }
+    // Pressed and released since: replay the tap rather than lose it
+    keyboard::InputEvent up = ev;
+    up.action = keyboard::InputEvent::Action::Up;
+    emitter_->emit(ev);
+    emitter_->emit(up);
+  }
+
+  void ReceiverFlow::release_held_events()
+  {
+    const auto now = clock::now();
+    while (!held_.empty())
+    {
+      const held_event h = held_.front();
+      const bool motion_arrived = h.event.motion_seq == 0 ||
+                                  motion_reader_.covers(h.event.motion_seq);
+      const bool in_order =
+          h.event.seq == 0 || !key_seq_known_ ||
+          static_cast<int32_t>(h.event.seq - next_key_seq_) <= 0;
+      const bool motion_wait =
+          !motion_arrived && now < h.received_at + kMotionFenceTimeout;
+      const bool order_wait =
+          !in_order && now < h.received_at + kKeyReorderTimeout;
+      if (motion_wait || order_wait)
+      {
+        return;
+      }
+      fence_timeouts_ += motion_arrived ? 0 : 1;
+      reorder_timeouts_ += in_order ? 0 : 1;
+      held_.pop_front();
+      emit_key_event(h.event, h.received_ns);
+    }
+  }
+
+  void ReceiverFlow::restart_key_session(uint32_t next_seq)
+  {
+    key_seq_known_ = true;
+    next_key_seq_ = next_seq;
+    key_top_seq_ = next_seq - 1;
+    applied_key_seqs_.reset();
+    key_sync_known_ = false;
+    key_seqs_.fill(0);
+    button_seqs_.fill(0);
+  }
+
+  bool ReceiverFlow::is_new_key_session(uint32_t seq) const
+  {
+    if (!key_seq_known_)
+    {
+      return true;
+    }
+    const int32_t ahead = static_cast<int32_t>(seq - next_key_seq_);
+    return ahead >= kKeySeqWindow || ahead <= -kKeySeqWindow;
+  }
+
+  bool ReceiverFlow::key_seq_applied(uint32_t seq) const
+  {
+    const int32_t behind = static_cast<int32_t>(key_top_seq_ - seq);
+    if (behind < 0)
+    {
+      return false;
+    }
+    return static_cast<size_t>(behind) >= kAppliedKeySeqWindow ||
+           applied_key_seqs_.test(static_cast<size_t>(behind));
+  }
+
+  void ReceiverFlow::mark_key_seq_applied(uint32_t seq)
+  {
+    const int32_t ahead = static_cast<int32_t>(seq - key_top_seq_);
+    if (ahead > 0)
+    {
+      if (static_cast<size_t>(ahead) >= kAppliedKeySeqWindow)
+      {
+        applied_key_seqs_.reset();
+      }
+      else
+      {
+        applied_key_seqs_ <<= static_cast<size_t>(ahead);
+      }
+      key_top_seq_ = seq;
+      applied_key_seqs_.set(0);
+    }
+    else if (static_cast<size_t>(-ahead) < kAppliedKeySeqWindow)
+    {
+      applied_key_seqs_.set(static_cast<size_t>(-ahead));
+    }
+  }
+
+  uint32_t* ReceiverFlow::last_code_seq(const keyboard::InputEvent& ev)
+  {
+    if (ev.action != keyboard::InputEvent::Action::Down &&
+        ev.action != keyboard::InputEvent::Action::Up)
+    {
+      return nullptr;
+    }
+    if (ev.type == keyboard::InputEvent::Type::Key)
+    {
+      return ev.code < key_seqs_.size() ? &key_seqs_[ev.code] : nullptr;
+    }
+    return ev.code < button_seqs_.size() ? &button_seqs_[ev.code] : nullptr;
+  }
+
+  bool ReceiverFlow::key_event_superseded(const keyboard::InputEvent& ev)
+  {
+    if (key_sync_known_ &&
+        static_cast<int32_t>(key_sync_seq_ - ev.seq) >= 0)
+    {
+      return true;
+    }
+    const uint32_t* last = last_code_seq(ev);
+    return last && *last != 0 && static_cast<int32_t>(*last - ev.seq) > 0;
+  }
+
+  void ReceiverFlow::apply_key_sync(const services::typed_package& package)
+  {
+    services::key_state_package pkg;
+    if (!services::key_state_package::decode(package.payload_data(),
+                                             package.payload_size(), pkg))
+    {
+      return;
+    }
+    last_heard_ = clock::now();
+    // Held events are newer than anything applied; wait for them to go out
+    // rather than reconciling around them
+    if (!held_.empty())
+    {
+      return;
+    }
+    const uint32_t seq = pkg.sync.seq;
+    if (is_new_key_session(seq + 1))
+    {
+      restart_key_session(seq + 1);
+    }
+    else if (static_cast<int32_t>(seq - key_top_seq_) < 0 ||
+             (key_sync_known_ &&
+              static_cast<int32_t>(seq - key_sync_seq_) < 0))
+    {
+      return; // older than an applied key event or sync; out of date
+    }
+    // Seqs up to the sync's are no longer waited for, but stay unapplied:
+    // if they still arrive, key_event_superseded() sorts them out
+    key_sync_known_ = true;
+    key_sync_seq_ = seq;
+    if (static_cast<int32_t>(seq + 1 - next_key_seq_) > 0)
+    {
+      next_key_seq_ = seq + 1;
+    }
+    if (pkg.sync.state != emitted_)
+    {
+      std::cout << "[receiver] Key state out of sync at seq " << pkg.sync.seq
+                << ", reconciling" << std::endl;
+      reconcile(pkg.sync.state);
+    }
+  }
+
+  void ReceiverFlow::reconcile(const keyboard::PressedState& target)
+  {
+    emitted_.diff(target,
+                  [this](const keyboard::InputEvent& ev)
+                  {
+                    if (emitter_)
+                    {
+                      emitter_->emit(ev);
+                    }
+                  });
+    emitted_ = target;
+  }
+
+  void ReceiverFlow::apply_motion(const services::typed_package& package)
+  {
+    services::motion_package pkg;
+    keyboard::MotionDeltas deltas{};
+    if (!services::motion_package::decode(package.payload_data(),
+                                          package.payload_size(), pkg) ||
+        !motion_reader_.accept(pkg.frame, deltas))
+    {
+      return;
+    }
+
+    static constexpr keyboard::InputEvent::Action kActions[] = {
+        keyboard::InputEvent::Action::Move,
+        keyboard::InputEvent::Action::Scroll};
+    static_assert(sizeof(kActions) / sizeof(kActions[0]) ==
+                      keyboard::MotionFrame::ChannelCount,
+                  "one action per motion channel");
+    for (size_t i = 0; i < deltas.size(); ++i)
+    {
+      if (deltas[i].empty())
+      {
+        continue;
+      }
+      keyboard::InputEvent ev{};
+      ev.type = keyboard::InputEvent::Type::Mouse;
+      ev.action = kActions[i];
+      ev.dx = deltas[i].dx;
+      ev.dy = deltas[i].dy;
+      emitter_->emit(ev);
+    }
+    release_held_events();
+  }
+
+} // namespace flows
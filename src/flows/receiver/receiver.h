@@ -0,0 +1,140 @@
+#pragma once
+
+#include "keyboard/keyboard.h"
+#include "keyboard/motion_stream.h"
+#include "keyboard/pressed_state.h"
+#include "services/communication/communication_service.h"
+#include "services/communication/packages/input_batch_package.h"
+#include "services/communication/typed_package.h"
+
+#include <array>
+#include <bitset>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace flows
+{
+
+  // Owns all inbound input traffic: decodes packages from the
+  // communication_service and injects them through the platform emitter.
+  //
+  // Key and button state is reconciled against the sender's periodic
+  // PressedStateSync: what was emitted is tracked, missing presses and
+  // releases are synthesized, and everything is released when the sender
+  // goes quiet for a few sync intervals.
+  //
+  // Key and button events wait for the motion frame they name in
+  // InputEvent::motion_seq, so a click lands where the pointer was on the
+  // sender. Motion stays unreliable: if that frame has not been applied or
+  // recovered within kMotionFenceTimeout, it is treated as lost and the
+  // event goes out anyway.
+  //
+  // Numbered key events may arrive more than once and out of order when the
+  // sender also sends redundant unreliable copies. They are deduplicated
+  // against the seqs actually applied and released in seq order; a gap is
+  // waited for up to one key state sync interval. Neither that timeout nor
+  // a sync marks the missing seqs as applied: when one arrives late it is
+  // still applied, unless newer state for its key already covers it. A late
+  // press that has since been released is replayed as a tap, so keystrokes
+  // are delayed rather than lost.
+  //
+  // Packages arrive on the transport's receive thread and update ticks on the
+  // services thread; both handlers hold m_ for their whole run.
+  class ReceiverFlow
+  {
+  public:
+    ~ReceiverFlow();
+
+    // Create the platform emitter and subscribe to incoming packages.
+    // Returns false if either is unavailable.
+    bool start();
+    // Unsubscribe and release the emitter.
+    void stop();
+
+  private:
+    using clock = std::chrono::steady_clock;
+
+    // Key/button events this far behind the last applied seq come from a
+    // new sender session rather than being late.
+    static constexpr int32_t kKeySeqWindow = 1 << 16;
+    // How far back applied key seqs are remembered; older ones are treated
+    // as applied.
+    static constexpr size_t kAppliedKeySeqWindow = 1024;
+    // Longest a key/button event waits for the motion before it; about
+    // three sender motion flush intervals.
+    static constexpr std::chrono::milliseconds kMotionFenceTimeout{25};
+    // Longest a key event waits for a missing earlier one
+    static constexpr std::chrono::milliseconds kKeyReorderTimeout =
+        keyboard::PressedStateSync::kInterval;
+
+    struct held_event
+    {
+      keyboard::InputEvent event;
+      clock::time_point received_at;
+      uint64_t received_ns; // latency reference from the package
+    };
+
+    void on_package(const services::typed_package& package);
+    void on_update();
+    void apply_key_event(const keyboard::InputEvent& ev, uint64_t received_ns);
+    void emit_key_event(const keyboard::InputEvent& ev, uint64_t received_ns);
+    // Emit held events, in seq order, that no longer wait for motion or an
+    // earlier key event (or have waited long enough).
+    void release_held_events();
+    // Start tracking a sender session whose next key event is 'next_seq'.
+    void restart_key_session(uint32_t next_seq);
+    // True for a seq too far from the tracked ones to be the same session.
+    bool is_new_key_session(uint32_t seq) const;
+    // True if 'seq' was applied, or is too old to tell.
+    bool key_seq_applied(uint32_t seq) const;
+    void mark_key_seq_applied(uint32_t seq);
+    // Seq of the last event applied for the event's key or button; null
+    // for untracked codes and non-key actions.
+    uint32_t* last_code_seq(const keyboard::InputEvent& ev);
+    // True if a newer event for the same key or button, or a key state sync
+    // taken after it, has already been applied.
+    bool key_event_superseded(const keyboard::InputEvent& ev);
+    // Apply an event that arrives after newer state for its code.
+    void apply_late_key_event(const keyboard::InputEvent& ev);
+    void apply_key_sync(const services::typed_package& package);
+    void apply_motion(const services::typed_package& package);
+    // Emit the events that bring the emitted key state to 'target'.
+    void reconcile(const keyboard::PressedState& target);
+
+    // Guards everything below against concurrent on_package/on_update
+    std::mutex m_;
+    std::unique_ptr<keyboard::Keyboard> kb_;
+    std::unique_ptr<keyboard::Emitter> emitter_;
+    keyboard::MotionStreamReader motion_reader_;
+    keyboard::PressedState emitted_;
+    // Decode target for legacy batches; keeps its event storage
+    services::input_batch_package batch_;
+    bool key_seq_known_ = false;
+    // Applied key seqs: bit i is key_top_seq_ - i
+    std::bitset<kAppliedKeySeqWindow> applied_key_seqs_;
+    uint32_t key_top_seq_ = 0; // newest seq applied
+    uint32_t next_key_seq_ = 0; // held events wait for this one
+    bool key_sync_known_ = false;
+    uint32_t key_sync_seq_ = 0; // last key state sync applied
+    // Per code; 0 when none (senders never number an event 0)
+    std::array<uint32_t, keyboard::PressedState::kMaxKeyCode> key_seqs_{};
+    std::array<uint32_t, keyboard::PressedState::kMaxButtonCode>
+        button_seqs_{};
+    clock::time_point last_heard_{};
+    std::deque<held_event> held_;
+    uint64_t fence_timeouts_ = 0;
+    uint64_t reorder_timeouts_ = 0;
+    uint64_t duplicate_keys_ = 0;
+    uint64_t late_keys_ = 0;
+
+    std::shared_ptr<services::communication_service> communication_service_;
+    utils::event_emitter<services::typed_package>::subscription_id
+        subscription_id_{0};
+    utils::event_emitter<void>::subscription_id update_subscription_id_{0};
+  };
+
+} // namespace flows
@@ -2,36 +2,55 @@
 #pragma once
 
 #include <atomic>
-#include <mutex>
+#include <cstdint>
 
 namespace flows
 {
 
+  // Wait-free: both axes live in one 64-bit word, so add() is a single
+  // fetch_add and take() a single exchange regardless of contention.
+  //
+  // The word holds dy * 2^32 + dx in two's complement. A negative dx borrows
+  // from the upper half on addition, which unpack() undoes, so each axis is
+  // exact as long as the pending sum stays within int32 between takes.
   struct MoveAggregator
   {
-    std::atomic<bool> running{true};
-    std::mutex m;
-    int agg_dx{0};
-    int agg_dy{0};
-
-    void add(int dx, int dy)
+    // Returns true when this add made a taken (empty) aggregator pending,
+    // the only add a parked consumer needs to hear about.
+    bool add(int dx, int dy)
     {
       if (dx == 0 && dy == 0)
       {
-        return;
+        return false;
       }
-      std::lock_guard<std::mutex> lock(m);
-      agg_dx += dx;
-      agg_dy += dy;
+      return packed_.fetch_add(pack(dx, dy), std::memory_order_relaxed) == 0;
     }
 
     void take(int& dx, int& dy)
     {
-      std::lock_guard<std::mutex> lock(m);
-      dx = agg_dx;
-      dy = agg_dy;
-      agg_dx = 0;
-      agg_dy = 0;
+      unpack(packed_.exchange(0, std::memory_order_relaxed), dx, dy);
+    }
+
+    bool pending() const
+    {
+      return packed_.load(std::memory_order_relaxed) != 0;
+    }
+
+  private:
+    std::atomic<uint64_t> packed_{0};
+
+    static uint64_t pack(int dx, int dy)
+    {
+      return (static_cast<uint64_t>(static_cast<int64_t>(dy)) << 32) +
+             static_cast<uint64_t>(static_cast<int64_t>(dx));
+    }
+
+    static void unpack(uint64_t v, int& dx, int& dy)
+    {
+      const int32_t x = static_cast<int32_t>(static_cast<uint32_t>(v));
+      v -= static_cast<uint64_t>(static_cast<int64_t>(x));
+      dx = x;
+      dy = static_cast<int32_t>(static_cast<uint32_t>(v >> 32));
     }
   };
 
@@ -2,20 +2,30 @@
 
 #include "keyboard/input_event.h"
 #include "services/communication/communication_service.h"
+#include "services/communication/packages/key_state_package.h"
 #include "services/communication/packages/keyboard_input_package.h"
+#include "services/communication/packages/motion_package.h"
 #include "services/service_locator.h"
-#include "store.h"
+#include "utils/latency/latency.h"
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
-#include <condition_variable>
 #include <iostream>
 #include <mutex>
+#include <random>
 #include <thread>
 
 namespace flows
 {
 
+  SenderFlow::SenderFlow() = default;
+
+  SenderFlow::~SenderFlow()
+  {
+    stop();
+  }
+
   bool SenderFlow::start()
   {
     communication_service_ =
@@ -29,12 +39,12 @@ namespace flows
       return false;
     }
 
-    moveAgg_.running.store(true, std::memory_order_relaxed);
-    scrollAgg_.running.store(true, std::memory_order_relaxed);
+    // Every session is a new motion stream for the receiver
+    motion_writer_ = keyboard::MotionStreamWriter();
+    key_seq_ = static_cast<uint32_t>(std::random_device{}());
+    pressed_.clear();
     running_.store(true, std::memory_order_relaxed);
-
-    moveThread_ = std::thread(&SenderFlow::move_loop, this);
-    scrollThread_ = std::thread(&SenderFlow::scroll_loop, this);
+    worker_ = std::thread(&SenderFlow::worker_loop, this);
     return true;
   }
 
@@ -44,15 +54,13 @@ namespace flows
     {
       return;
     }
-    moveAgg_.running.store(false, std::memory_order_relaxed);
-    scrollAgg_.running.store(false, std::memory_order_relaxed);
-    if (moveThread_.joinable())
     {
-      moveThread_.join();
+      std::lock_guard<std::mutex> lock(wake_m_);
     }
-    if (scrollThread_.joinable())
+    wake_cv_.notify_one();
+    if (worker_.joinable())
     {
-      scrollThread_.join();
+      worker_.join();
     }
     communication_service_ = nullptr;
   }
@@ -63,23 +71,252 @@ namespace flows
     {
       return;
     }
+    utils::latency::record_since(utils::latency::stage::capture_to_enqueue,
+                                 ev.timestamp_ns);
     if (ev.type == keyboard::InputEvent::Type::Mouse &&
         ev.action == keyboard::InputEvent::Action::Move)
     {
-      moveAgg_.add(ev.dx, ev.dy);
+      if (add_motion(channels_[kMoveChannel], ev))
+      {
+        wake();
+      }
+    }
+    else if (ev.type == keyboard::InputEvent::Type::Mouse &&
+             ev.action == keyboard::InputEvent::Action::Scroll)
+    {
+      if (add_motion(channels_[kScrollChannel], ev))
+      {
+        wake();
+      }
+    }
+    else
+    {
+      // Key state must not be lost; a full inbox only means the worker is
+      // momentarily behind.
+      while (!inbox_.try_push(ev))
+      {
+        if (!running_.load(std::memory_order_relaxed))
+        {
+          return;
+        }
+        wake();
+        std::this_thread::yield();
+      }
+      wake();
+    }
+  }
+
+  bool SenderFlow::add_motion(motion_channel& ch,
+                              const keyboard::InputEvent& ev)
+  {
+    // Stamp before adding so a take() that sees the delta usually finds
+    // its stamp too; a rare mismatch only skews one latency sample.
+    uint64_t unset = 0;
+    if (ev.timestamp_ns != 0 &&
+        ch.first_capture_ns.load(std::memory_order_relaxed) == 0)
+    {
+      ch.first_capture_ns.compare_exchange_strong(unset, ev.timestamp_ns,
+                                                  std::memory_order_relaxed);
+    }
+    if (!ch.agg.add(ev.dx, ev.dy))
+    {
+      return false;
+    }
+    // An armed channel's timer takes the delta anyway. Pairs with the fence
+    // in park(): either we see the timer disarmed, or the worker sees this
+    // delta in has_work() before it sleeps.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return !ch.armed.load(std::memory_order_relaxed);
+  }
+
+  void SenderFlow::set_redundant_key_delivery(
+      int copies, std::chrono::microseconds spacing)
+  {
+    if (running_.load(std::memory_order_relaxed))
+    {
+      std::cerr << "[sender] Ignoring redundant key delivery change while "
+                   "running"
+                << std::endl;
       return;
     }
-    if (ev.type == keyboard::InputEvent::Type::Mouse &&
-        ev.action == keyboard::InputEvent::Action::Scroll)
+    redundant_key_copies_ = copies < 0 ? 0 : copies;
+    redundant_key_spacing_ = spacing;
+  }
+
+  void SenderFlow::worker_loop()
+  {
+    wheel_ = utils::timer_wheel(std::chrono::milliseconds(1), clock::now());
+    send_key_sync();
+    wheel_.schedule(kKeySyncTimer,
+                    clock::now() + keyboard::PressedStateSync::kInterval);
+    while (running_.load(std::memory_order_relaxed))
+    {
+      drain_inbox();
+
+      const auto now = clock::now();
+      wheel_.advance(now, [this](utils::timer_wheel::timer_id id)
+                     { on_timer(id); });
+      for (size_t i = 0; i < channels_.size(); ++i)
+      {
+        kick_channel(static_cast<utils::timer_wheel::timer_id>(i), now);
+      }
+      flush_motion();
+
+      park(wheel_.next_expiry());
+    }
+
+    for (auto& ch : channels_)
+    {
+      int dx = 0, dy = 0;
+      ch.agg.take(dx, dy);
+      ch.first_capture_ns.store(0, std::memory_order_relaxed);
+      ch.armed.store(false, std::memory_order_relaxed);
+    }
+    motion_frame_ = {};
+    motion_frame_capture_ns_ = 0;
+    motion_frame_pending_ = false;
+    key_copies_.clear();
+    wheel_ = utils::timer_wheel();
+  }
+
+  void SenderFlow::drain_inbox()
+  {
+    keyboard::InputEvent ev{};
+    while (inbox_.try_pop(ev))
+    {
+      // A click has to land where the pointer is: ship pending motion on
+      // the same pointer first.
+      if (ev.type == keyboard::InputEvent::Type::Mouse &&
+          take_motion(kMoveChannel))
+      {
+        flush_motion();
+      }
+      send_discrete(ev);
+    }
+  }
+
+  void SenderFlow::kick_channel(utils::timer_wheel::timer_id id,
+                                clock::time_point now)
+  {
+    motion_channel& ch = channels_[id];
+    if (ch.armed.load(std::memory_order_relaxed) || !take_motion(id))
     {
-      scrollAgg_.add(ev.dx, ev.dy);
       return;
     }
+    ch.armed.store(true, std::memory_order_relaxed);
+    ch.next_flush = now + kMotionFlushInterval;
+    wheel_.schedule(id, ch.next_flush);
+  }
 
+  void SenderFlow::on_timer(utils::timer_wheel::timer_id id)
+  {
+    if (id == kKeySyncTimer)
+    {
+      send_key_sync();
+      wheel_.schedule(kKeySyncTimer,
+                      clock::now() + keyboard::PressedStateSync::kInterval);
+      return;
+    }
+    if (id == kKeyCopyTimer)
+    {
+      send_key_copies(clock::now());
+      return;
+    }
+    on_flush_timer(id);
+  }
+
+  void SenderFlow::on_flush_timer(utils::timer_wheel::timer_id id)
+  {
+    motion_channel& ch = channels_[id];
+    if (!take_motion(id))
+    {
+      // Idle for a whole interval
+      ch.armed.store(false, std::memory_order_relaxed);
+      return;
+    }
+    // Keep a steady cadence rather than drifting by the wakeup latency
+    ch.next_flush += kMotionFlushInterval;
+    wheel_.schedule(id, ch.next_flush);
+  }
+
+  bool SenderFlow::take_motion(utils::timer_wheel::timer_id id)
+  {
+    motion_channel& ch = channels_[id];
+    int dx = 0, dy = 0;
+    ch.agg.take(dx, dy);
+    if (dx == 0 && dy == 0)
+    {
+      return false;
+    }
+    keyboard::MotionDelta& d = motion_frame_[id];
+    d.dx += dx;
+    d.dy += dy;
+    const uint64_t captured =
+        ch.first_capture_ns.exchange(0, std::memory_order_relaxed);
+    if (captured != 0 && (motion_frame_capture_ns_ == 0 ||
+                          captured < motion_frame_capture_ns_))
+    {
+      motion_frame_capture_ns_ = captured;
+    }
+    motion_frame_pending_ = true;
+    return true;
+  }
+
+  void SenderFlow::flush_motion()
+  {
+    if (!motion_frame_pending_)
+    {
+      return;
+    }
+    if (communication_service_)
+    {
+      auto pkg = services::motion_package::build(
+          motion_writer_.next(motion_frame_));
+      pkg.meta.set_timestamp_ns(motion_frame_capture_ns_);
+      communication_service_->send_package_unreliable(pkg);
+    }
+    else
+    {
+      std::cerr << "[sender] Unable to send motion: communication_service_ "
+                   "is null"
+                << std::endl;
+    }
+    motion_frame_ = {};
+    motion_frame_capture_ns_ = 0;
+    motion_frame_pending_ = false;
+  }
+
+  void SenderFlow::send_discrete(keyboard::InputEvent ev)
+  {
+    // 0 means unnumbered to the receiver
+    if (++key_seq_ == 0)
+    {
+      ++key_seq_;
+    }
+    ev.seq = key_seq_;
+    ev.motion_seq = motion_writer_.last_seq();
+    pressed_.apply(ev);
     if (communication_service_)
     {
-      communication_service_->send_package_reliable(
-          services::keyboard_input_package::build(ev));
+      auto pkg = services::keyboard_input_package::build(ev);
+      if (redundant_key_copies_ > 0)
+      {
+        // Only the reliable send carries the capture stamp, so each event
+        // is one latency sample
+        communication_service_->send_package_unreliable(pkg);
+        if (redundant_key_copies_ > 1)
+        {
+          key_copies_.push_back(key_copy{
+              pkg, clock::now() + redundant_key_spacing_,
+              redundant_key_copies_ - 1});
+          if (!wheel_.scheduled(kKeyCopyTimer))
+          {
+            wheel_.schedule(kKeyCopyTimer, key_copies_.back().due);
+          }
+        }
+      }
+      pkg.meta.set_timestamp_ns(ev.timestamp_ns);
+      communication_service_->send_package_reliable(pkg);
     }
     else
     {
@@ -89,80 +326,96 @@ namespace flows
     }
   }
 
-  void SenderFlow::push_event(const SDL_Event& sdl_ev)
+  void SenderFlow::send_key_sync()
   {
-    const auto ev = keyboard::InputEvent::fromSDL(sdl_ev);
-    push_event(ev);
+    if (!communication_service_)
+    {
+      return;
+    }
+    keyboard::PressedStateSync sync;
+    sync.seq = key_seq_;
+    sync.state = pressed_;
+    communication_service_->send_package_unreliable(
+        services::key_state_package::build(sync));
   }
 
-  void SenderFlow::move_loop()
+  void SenderFlow::send_key_copies(clock::time_point now)
   {
-    using namespace std::chrono;
-    const int throttle_ms = 8;
-    while (moveAgg_.running.load(std::memory_order_relaxed))
+    auto next = clock::time_point::max();
+    for (auto it = key_copies_.begin(); it != key_copies_.end();)
     {
-      std::this_thread::sleep_for(milliseconds(throttle_ms));
-      int dx = 0, dy = 0;
-      moveAgg_.take(dx, dy);
-      if (dx == 0 && dy == 0)
+      if (it->due <= now)
       {
-        continue;
-      }
-      keyboard::InputEvent mv{};
-      mv.type = keyboard::InputEvent::Type::Mouse;
-      mv.action = keyboard::InputEvent::Action::Move;
-      mv.code = 0;
-      mv.dx = dx;
-      mv.dy = dy;
-      const std::string payload = keyboard::InputEventJSONConverter::encode(mv);
-
-      if (communication_service_)
-      {
-        communication_service_->send_package_unreliable(
-            services::keyboard_input_package::build(mv));
-      }
-      else
-      {
-        std::cerr
-            << "[sender] Unable to send move: communication_service_ is null"
-            << std::endl;
+        if (communication_service_)
+        {
+          communication_service_->send_package_unreliable(it->package);
+        }
+        it->due += redundant_key_spacing_;
+        if (--it->remaining == 0)
+        {
+          it = key_copies_.erase(it);
+          continue;
+        }
       }
+      next = std::min(next, it->due);
+      ++it;
+    }
+    if (!key_copies_.empty())
+    {
+      wheel_.schedule(kKeyCopyTimer, next);
     }
   }
 
-  void SenderFlow::scroll_loop()
+  void SenderFlow::wake()
   {
-    using namespace std::chrono;
-    const int throttle_ms = 8;
-    while (scrollAgg_.running.load(std::memory_order_relaxed))
+    // Motion only calls this for the delta that made an idle channel
+    // pending: later ones are still pending when the worker re-checks, and
+    // an armed channel's timer takes whatever arrives, so neither needs a
+    // wakeup.
+    //
+    // Pairs with the fence in park(): either the worker sees our input when
+    // it re-checks, or we see it parked and notify.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (parked_.load(std::memory_order_relaxed))
     {
-      std::this_thread::sleep_for(milliseconds(throttle_ms));
-      int sx = 0, sy = 0;
-      scrollAgg_.take(sx, sy);
-      if (sx == 0 && sy == 0)
-      {
-        continue;
-      }
-      keyboard::InputEvent sc{};
-      sc.type = keyboard::InputEvent::Type::Mouse;
-      sc.action = keyboard::InputEvent::Action::Scroll;
-      sc.code = 0;
-      sc.dx = sx;
-      sc.dy = sy;
-      const std::string payload = keyboard::InputEventJSONConverter::encode(sc);
-
-      if (communication_service_)
       {
-        communication_service_->send_package_unreliable(
-            services::keyboard_input_package::build(sc));
+        std::lock_guard<std::mutex> lock(wake_m_);
       }
-      else
+      wake_cv_.notify_one();
+    }
+  }
+
+  bool SenderFlow::has_work() const
+  {
+    if (!running_.load(std::memory_order_relaxed) || !inbox_.empty())
+    {
+      return true;
+    }
+    for (const auto& ch : channels_)
+    {
+      // Armed channels are flushed by their timer, not by new input
+      if (!ch.armed.load(std::memory_order_relaxed) && ch.agg.pending())
       {
-        std::cerr
-            << "[sender] Unable to send scroll: communication_service_ is null"
-            << std::endl;
+        return true;
       }
     }
+    return false;
+  }
+
+  void SenderFlow::park(clock::time_point deadline)
+  {
+    std::unique_lock<std::mutex> lock(wake_m_);
+    parked_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (deadline == clock::time_point::max())
+    {
+      wake_cv_.wait(lock, [this] { return has_work(); });
+    }
+    else
+    {
+      wake_cv_.wait_until(lock, deadline, [this] { return has_work(); });
+    }
+    parked_.store(false, std::memory_order_relaxed);
   }
 
 } // namespace flows
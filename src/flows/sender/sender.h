@@ -1,11 +1,21 @@
 #pragma once
 
 #include "keyboard/input_event.h"
+#include "keyboard/motion_stream.h"
+#include "keyboard/pressed_state.h"
 #include "move_aggregator.h"
 #include "services/communication/communication_service.h"
+#include "utils/mpsc_queue/mpsc_queue.h"
+#include "utils/timer_wheel/timer_wheel.h"
 
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <vector>
 #include <memory>
+#include <mutex>
 #include <thread>
 
 union SDL_Event;
@@ -13,30 +23,145 @@ union SDL_Event;
 namespace flows
 {
 
+  // Owns all outbound input traffic on a single worker thread.
+  //
+  // Capture threads call push_event(), which never blocks: discrete events
+  // (keys, buttons) go into a lock-free MPSC inbox, and continuous ones
+  // (motion, scroll) are summed into a per-class MoveAggregator. The worker
+  // drains the inbox first, so discrete events always overtake pending
+  // motion, then flushes motion classes on coalescing deadlines kept in a
+  // timer wheel. It parks while there is neither input nor an armed timer.
+  // Motion leaves as one loss-tolerant MotionFrame per flush, so a dropped
+  // datagram delays travel instead of losing it. Key and button events are
+  // numbered and also reflected in a periodic unreliable PressedStateSync,
+  // so the receiver can repair stuck keys without waiting on ENet. They
+  // also name the last motion frame sent before them, which the receiver
+  // applies first.
+  //
+  // Optionally each key event is also sent as a few unreliable copies a few
+  // milliseconds apart, ahead of the reliable one, so a single lost datagram
+  // costs one spacing instead of an ENet retransmit timeout.
+  //
+  // A new continuous traffic class is one more motion_channel; it shares the
+  // worker, the wheel and the wakeup path.
   class SenderFlow
   {
   public:
+    // Motion coalescing period while the mouse keeps moving; ~120 Hz.
+    static constexpr std::chrono::microseconds kMotionFlushInterval{8000};
+    static constexpr size_t kInboxCapacity = 1024;
+    // Redundant key delivery is off unless enabled
+    static constexpr int kDefaultRedundantKeyCopies = 0;
+    static constexpr std::chrono::microseconds kDefaultRedundantKeySpacing{
+        3000};
+
+    SenderFlow();
+    ~SenderFlow();
+
     // Start the sender: connects to the device from store::connection_state and
     // spawns workers. Returns true if started, false if no target or connection
     // failed.
     bool start();
     // Stop background workers and disconnect.
     void stop();
-    // Submit an input event to be sent; coalesces move/scroll.
+    // Submit an input event to be sent; coalesces move/scroll. Safe to call
+    // from any thread.
     void push_event(const keyboard::InputEvent& ev);
-    void push_event(const SDL_Event& sdl_ev);
+    // Inline so that code pushing InputEvents only (keyleport_bench) links
+    // without SDL.
+    void push_event(const SDL_Event& sdl_ev)
+    {
+      push_event(keyboard::InputEvent::fromSDL(sdl_ev));
+    }
+
+    // Send each key/button event 'copies' times over the unreliable channel,
+    // 'spacing' apart, in addition to the reliable send; 0 turns this off.
+    // Must be called before start(): the worker reads these settings
+    // unsynchronized, so calls while running are ignored.
+    void set_redundant_key_delivery(
+        int copies,
+        std::chrono::microseconds spacing = kDefaultRedundantKeySpacing);
 
   private:
-    // Background workers
-    void move_loop();
-    void scroll_loop();
+    using clock = std::chrono::steady_clock;
+
+    // A continuous traffic class. The first delta after idle is sent at once;
+    // further deltas are coalesced until one interval passes without any.
+    struct motion_channel
+    {
+      MoveAggregator agg;
+      // Capture time of the oldest delta in 'agg'; 0 when none is stamped
+      std::atomic<uint64_t> first_capture_ns{0};
+      // Flush timer scheduled; written by the worker, read by producers
+      std::atomic<bool> armed{false};
+      clock::time_point next_flush{};
+    };
+
+    // Indices match keyboard::MotionFrame::Channel
+    enum channel_id : utils::timer_wheel::timer_id
+    {
+      kMoveChannel = keyboard::MotionFrame::Move,
+      kScrollChannel = keyboard::MotionFrame::Scroll,
+      kChannelCount = keyboard::MotionFrame::ChannelCount
+    };
+    static constexpr utils::timer_wheel::timer_id kKeySyncTimer =
+        kChannelCount;
+    static constexpr utils::timer_wheel::timer_id kKeyCopyTimer =
+        kChannelCount + 1;
+
+    // Pending unreliable copies of one key event
+    struct key_copy
+    {
+      services::typed_package package;
+      clock::time_point due;
+      int remaining;
+    };
+
+    // Returns true when 'ev' made an idle channel pending, i.e. needs a
+    // wake().
+    bool add_motion(motion_channel& ch, const keyboard::InputEvent& ev);
+    void worker_loop();
+    void drain_inbox();
+    // Send anything pending on an idle channel and arm its flush timer.
+    void kick_channel(utils::timer_wheel::timer_id id, clock::time_point now);
+    void on_timer(utils::timer_wheel::timer_id id);
+    void on_flush_timer(utils::timer_wheel::timer_id id);
+    // Move the channel's pending delta into the next motion frame. Returns
+    // false when nothing was pending.
+    bool take_motion(utils::timer_wheel::timer_id id);
+    // Send the next motion frame if any channel contributed to it.
+    void flush_motion();
+    void send_discrete(keyboard::InputEvent ev);
+    void send_key_sync();
+    // Send the key copies that are due and re-arm the copy timer.
+    void send_key_copies(clock::time_point now);
+
+    // Wake the worker if it is parked. Discrete events always call it;
+    // motion only when it makes a channel without an armed timer pending.
+    void wake();
+    bool has_work() const;
+    void park(clock::time_point deadline);
 
     // State
-    MoveAggregator moveAgg_;
-    MoveAggregator scrollAgg_;
-    std::thread moveThread_;
-    std::thread scrollThread_;
+    std::array<motion_channel, kChannelCount> channels_;
+    utils::mpsc_queue<keyboard::InputEvent, kInboxCapacity> inbox_;
+    utils::timer_wheel wheel_;
+    keyboard::MotionStreamWriter motion_writer_;
+    keyboard::MotionDeltas motion_frame_{};
+    uint64_t motion_frame_capture_ns_ = 0; // oldest capture time in the frame
+    bool motion_frame_pending_ = false;
+    keyboard::PressedState pressed_;
+    uint32_t key_seq_ = 0; // seq of the last key/button event sent
+    int redundant_key_copies_ = kDefaultRedundantKeyCopies;
+    std::chrono::microseconds redundant_key_spacing_{
+        kDefaultRedundantKeySpacing};
+    std::vector<key_copy> key_copies_;
+
+    std::thread worker_;
     std::atomic<bool> running_{false};
+    std::atomic<bool> parked_{false};
+    std::mutex wake_m_;
+    std::condition_variable wake_cv_;
 
     std::shared_ptr<services::communication_service> communication_service_;
   };
@@ -2,6 +2,7 @@
 
 #include "ui_scene.h"
 
+#include <functional>
 #include <memory>
 #include <utility>
 
@@ -30,6 +31,16 @@ namespace gui
 
       // Release any mouse confinement applied previously.
       virtual void release_mouse_confinement() = 0;
+
+      // Receives every event when the window pumps platform events: at the
+      // start of each frame and once more before render/present. That skips
+      // the wait for ImGui and the scene but not present or vsync; input
+      // arriving while the frame is presented is still seen on the next
+      // pump. Runs on the UI thread inside the pump, so it must not block.
+      // The scene still gets its own copy through handleInput(). Pass an
+      // empty function to remove; at most one watch is installed.
+      using input_watch = std::function<void(const SDL_Event&)>;
+      virtual void set_input_watch(input_watch watch) = 0;
     };
 
     // Initializes the concrete window (SDL + ImGui) instance.
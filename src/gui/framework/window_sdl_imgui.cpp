@@ -4,6 +4,7 @@
 
 #include <stdexcept>
 #include <string>
+#include <utility>
 // extras
 #include <cstdlib>
 
@@ -126,6 +127,7 @@ namespace gui
         scene_->willUnmount();
         scene_ = nullptr;
       }
+      set_input_watch(nullptr);
 
       // Shutdown ImGui backends and context
       ImGui_ImplSDLRenderer3_Shutdown();
@@ -211,6 +213,35 @@ namespace gui
       SDL_SetWindowMouseRect(window_, nullptr);
     }
 
+    bool SDLCALL SdlImGuiWindow::on_sdl_event_watch(void* userdata,
+                                                    SDL_Event* event)
+    {
+      auto* self = static_cast<SdlImGuiWindow*>(userdata);
+      if (self && event && self->input_watch_)
+      {
+        self->input_watch_(*event);
+      }
+      return true; // return value is ignored for watches
+    }
+
+    void SdlImGuiWindow::set_input_watch(input_watch watch)
+    {
+      // SDL serializes watch callbacks with add/remove, so once removed the
+      // old function is no longer running and can be replaced safely.
+      if (input_watch_)
+      {
+        SDL_RemoveEventWatch(&SdlImGuiWindow::on_sdl_event_watch, this);
+      }
+      input_watch_ = std::move(watch);
+      if (input_watch_ &&
+          !SDL_AddEventWatch(&SdlImGuiWindow::on_sdl_event_watch, this))
+      {
+        std::cerr << "SDL_AddEventWatch failed: " << SDL_GetError()
+                  << std::endl;
+        input_watch_ = nullptr;
+      }
+    }
+
     bool SdlImGuiWindow::frame()
     {
       if (!initialized_)
@@ -286,6 +317,16 @@ namespace gui
       // networking threads)
       gui::framework::process_ui_tasks();
 
+      // Pump once more before the (potentially slow) render and present so
+      // input that arrived while building the frame reaches the input watch
+      // now rather than at the start of the next frame. Input arriving
+      // during present and vsync still waits for the next pump. The events
+      // stay queued for the UI.
+      if (input_watch_)
+      {
+        SDL_PumpEvents();
+      }
+
       // Rendering
       ImGui::Render();
       SDL_SetRenderDrawColor(renderer_, 0, 0, 0, 255);
@@ -29,6 +29,8 @@ namespace gui
       void apply_mouse_confinement() override;
       void release_mouse_confinement() override;
 
+      void set_input_watch(input_watch watch) override;
+
       // Pump one frame: process events, begin/end ImGui frame, render scene
       // Returns false when the application should quit.
       bool frame();
@@ -47,6 +49,9 @@ namespace gui
       bool initialized_ = false;
 
       UIScene* scene_ = nullptr; // non-owning; lifetime managed by caller
+      input_watch input_watch_;
+
+      static bool SDLCALL on_sdl_event_watch(void* userdata, SDL_Event* event);
     };
   } // namespace framework
 } // namespace gui
@@ -34,62 +34,56 @@ void HomeScene::didMount()
   services::service_locator::instance().repository.add_service(
       communication_service_);
 
+  // Runs on the transport's receive thread: decode the borrowed payload
+  // there, then leave connecting (which may tear down the previous client
+  // and join its thread) to the services thread so input keeps flowing.
   communication_subscription_id_ = communication_service_->on_package.subscribe(
-      [this](const services::typed_package& package)
+      [communication = communication_service_](
+          const services::typed_package& package)
       {
         if (!services::become_receiver_package::is(package))
         {
           return;
         }
+        const auto become_receiver = services::become_receiver_package::decode(
+            package.payload_data(), package.payload_size());
+        const std::string from_ip = package.meta.get_from().get_ip_address();
+        services::service_locator::instance().main_loop->post(
+            [communication, from_ip, device_id = become_receiver.device_id]
+            { accept_become_receiver(communication, from_ip, device_id); });
+      });
+}
 
-        std::cout << "[home_scene] Received package type='"
-                  << package.__typename << "' size=" << package.payload.size()
-                  << std::endl;
-
-        auto become_receiver =
-            services::become_receiver_package::decode(package.payload);
-
-        std::cout << "[home_scene] Decoded become_receiver device_id='"
-                  << become_receiver.device_id << "'" << std::endl;
-
-        // Try to find the device by ID in the store's available devices
-        const auto devices =
-            store::connection_state().available_devices.value();
-
-        std::shared_ptr<entities::ConnectionCandidate> candidate;
-        if (auto it = std::find_if(
-                devices.begin(), devices.end(), [&](const auto& d)
-                { return d.ip() == package.meta.get_from().get_ip_address(); });
-            it != devices.end())
-        {
-          candidate = std::make_shared<entities::ConnectionCandidate>(*it);
-          std::cout << "[home_scene] Matched candidate for device_id="
-                    << become_receiver.device_id << std::endl;
-        }
-        else
-        {
-          std::cerr << "Received become_receiver package from unknown device: "
-                    << become_receiver.device_id << std::endl;
-          return;
-        }
+void HomeScene::accept_become_receiver(
+    const std::shared_ptr<services::communication_service>& communication,
+    const std::string& from_ip, uint64_t device_id)
+{
+  std::cout << "[home_scene] become_receiver from " << from_ip
+            << " device_id=" << device_id << std::endl;
 
-        // Accept the connection request
-        store::connection_state().connected_device.set(candidate);
-        std::cout << "[home_scene] Set connected_device ip=" << candidate->ip()
-                  << std::endl;
+  // Try to find the device by IP in the store's available devices
+  const auto devices = store::connection_state().available_devices.value();
+  auto it = std::find_if(devices.begin(), devices.end(),
+                         [&](const auto& d) { return d.ip() == from_ip; });
+  if (it == devices.end())
+  {
+    std::cerr << "Received become_receiver package from unknown device: "
+              << device_id << std::endl;
+    return;
+  }
 
-        // Pin the communication service to this peer
-        communication_service_->pin_connection(p2p::peer(candidate->ip()));
+  // Accept the connection request
+  auto candidate = std::make_shared<entities::ConnectionCandidate>(*it);
+  store::connection_state().connected_device.set(candidate);
 
-        std::cout << "[home_scene] Pinned communication to " << candidate->ip()
-                  << std::endl;
+  // Pin the communication service to this peer
+  communication->pin_connection(p2p::peer(candidate->ip()));
 
-        // Switch to the receiver scene
-        gui::framework::post_to_ui(
-            [] { gui::framework::set_window_scene<ReceiverScene>(); });
-        std::cout << "[home_scene] Posted UI task to switch to ReceiverScene"
-                  << std::endl;
-      });
+  // Switch to the receiver scene
+  gui::framework::post_to_ui(
+      [] { gui::framework::set_window_scene<ReceiverScene>(); });
+  std::cout << "[home_scene] Pinned " << candidate->ip()
+            << ", switching to ReceiverScene" << std::endl;
 }
 
 void HomeScene::render()
@@ -152,7 +146,7 @@ void HomeScene::render()
         communication_service_->pin_connection(p2p::peer(d.ip()));
         // Send become_receiver package
         services::typed_package pkg;
-        pkg.__typename = services::become_receiver_package::__typename;
+        pkg.type = services::become_receiver_package::type;
 
         services::become_receiver_package become_receiver_pkg;
         become_receiver_pkg.device_id = discovery_service_->self_peer.device_id;
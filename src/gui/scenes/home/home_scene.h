@@ -7,6 +7,7 @@
 
 #include <cstdint>
 #include <memory>
+#include <string>
 #include <thread>
 
 class HomeScene : public gui::framework::UIScene
@@ -17,6 +18,13 @@ public:
   void render() override;
 
 private:
+  // Pins the device that sent a become_receiver package and switches to the
+  // receiver scene. Runs on the services thread, after the scene may already
+  // be gone, so it only touches what it is given and the store.
+  static void accept_become_receiver(
+      const std::shared_ptr<services::communication_service>& communication,
+      const std::string& from_ip, uint64_t device_id);
+
   std::shared_ptr<services::discovery_service> discovery_service_;
   std::shared_ptr<services::communication_service> communication_service_;
   std::uint16_t communication_subscription_id_;
@@ -1,70 +1,22 @@
 #include "receiver_scene.h"
 
 #include "gui/framework/ui_window.h"
-#include "keyboard/input_event.h"
-#include "keyboard/keyboard.h"
-#include "services/communication/communication_service.h"
-#include "services/communication/packages/keyboard_input_package.h"
-#include "services/service_locator.h"
 #include "store.h"
 
 #include <imgui.h>
-#include <iostream>
 
 void ReceiverScene::didMount()
 {
-  // Create keyboard and emitter for injecting received events
-  kb_ = keyboard::make_keyboard();
-  emitter_ = kb_ ? kb_->createEmitter() : nullptr;
-
-  // Subscribe to received data and emit as input events
-  keyboard::Emitter* emitter_ptr = emitter_.get();
-
-  auto communication_service =
-      services::service_locator::instance()
-          .repository.get_service<services::communication_service>();
-
-  if (communication_service)
-  {
-    communication_subscription_id_ =
-        communication_service->on_package.subscribe(
-            [emitter_ptr](const services::typed_package& package)
-            {
-              if (!emitter_ptr ||
-                  !services::keyboard_input_package::is(package))
-              {
-                return;
-              }
-              auto ev =
-                  services::keyboard_input_package::decode(package.payload)
-                      .event;
-              emitter_ptr->emit(ev);
-            });
-
-    std::cout << "[receiver_scene] Subscribed to communication_service with id "
-              << communication_subscription_id_ << std::endl;
-  }
-  else
-  {
-    std::cerr << "[receiver_scene] communication_service not found"
-              << std::endl;
-  }
+  flow_.reset(new flows::ReceiverFlow());
+  flow_->start();
 }
 
 void ReceiverScene::willUnmount()
 {
-  emitter_.reset();
-  kb_.reset();
-  auto communication_service =
-      services::service_locator::instance()
-          .repository.get_service<services::communication_service>();
-
-  if (communication_service)
+  if (flow_)
   {
-    communication_service->on_package.unsubscribe(
-        communication_subscription_id_);
-    std::cout << "[receiver_scene] Unsubscribed from communication_service id "
-              << communication_subscription_id_ << std::endl;
+    flow_->stop();
+    flow_.reset();
   }
 }
 
@@ -1,8 +1,8 @@
 // Simple scene that renders a centered "Hello world!" message
 #pragma once
 
+#include "flows/receiver/receiver.h"
 #include "gui/framework/ui_scene.h"
-#include "keyboard/keyboard.h"
 
 #include <memory>
 
@@ -14,8 +14,5 @@ public:
 
 private:
   void render() override;
-  // Keyboard injection components
-  std::unique_ptr<keyboard::Keyboard> kb_;
-  std::unique_ptr<keyboard::Emitter> emitter_;
-  uint16_t communication_subscription_id_;
+  std::unique_ptr<flows::ReceiverFlow> flow_;
 };
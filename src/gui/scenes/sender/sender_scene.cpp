@@ -13,10 +13,13 @@ void SenderScene::didMount()
   apply_mouse_confinement();
   flow_.reset(new flows::SenderFlow());
   flow_->start();
+  gui::framework::get_window().set_input_watch(
+      [this](const SDL_Event& event) { on_captured_event(event); });
 }
 
 void SenderScene::willUnmount()
 {
+  gui::framework::get_window().set_input_watch(nullptr);
   release_mouse_confinement();
   if (flow_)
   {
@@ -40,18 +43,34 @@ void SenderScene::handleInput(const gui::framework::UIInputEvent& event)
     release_mouse_confinement();
   }
 
+  // Already forwarded by on_captured_event(); just keep it away from ImGui
   if (is_mouse_contained_)
   {
-    // Convert and forward to flow (which uses P2P service)
-    const auto ev = keyboard::InputEvent::fromSDL(event.raw_event);
-    if (flow_)
-    {
-      flow_->push_event(ev);
-    }
     event.stopPropagation();
   }
 }
 
+void SenderScene::on_captured_event(const SDL_Event& event)
+{
+  if (!is_mouse_contained_ || !keyboard::InputEvent::isInputSDL(event))
+  {
+    return;
+  }
+  // The release hotkey must not reach the peer. handleInput() performs the
+  // actual release on the UI thread.
+  if (event.type == SDL_EVENT_KEY_DOWN &&
+      event.key.scancode == SDL_SCANCODE_ESCAPE &&
+      (event.key.mod & SDL_KMOD_LCTRL) && (event.key.mod & SDL_KMOD_LALT))
+  {
+    is_mouse_contained_ = false;
+    return;
+  }
+  if (flow_)
+  {
+    flow_->push_event(event);
+  }
+}
+
 void SenderScene::render()
 {
   // Root window for the scene (fullscreen, no decorations)
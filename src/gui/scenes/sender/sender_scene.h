@@ -4,6 +4,9 @@
 #include "flows/sender/sender.h"
 #include "gui/framework/ui_scene.h"
 
+#include <atomic>
+#include <memory>
+
 class SenderScene : public gui::framework::UIScene
 {
 public:
@@ -15,6 +18,9 @@ private:
   void render() override;
   void apply_mouse_confinement();
   void release_mouse_confinement();
-  bool is_mouse_contained_ = true;
+  // Capture path: runs from the window's input watch, possibly off the UI
+  // thread, as soon as SDL queues the event.
+  void on_captured_event(const SDL_Event& event);
+  std::atomic<bool> is_mouse_contained_{true};
   std::unique_ptr<flows::SenderFlow> flow_;
 };
@@ -0,0 +1,274 @@
+#include "headless/headless.h"
+
+#include "flows/receiver/receiver.h"
+#include "flows/sender/sender.h"
+#include "keyboard/input_event.h"
+#include "networking/p2p/peer.h"
+#include "networking/p2p/transport.h"
+#include "services/communication/communication_service.h"
+#include "services/communication/packages/become_receiver_package.h"
+#include "services/discovery/discovery_service.h"
+#include "services/main_loop/main_loop.h"
+#include "services/service_locator.h"
+#include "utils/latency/latency.h"
+#include "utils/log/log.h"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace headless
+{
+  namespace
+  {
+    // Time for the last events of an input script to reach the receiver
+    constexpr std::chrono::milliseconds kDrainDelay{200};
+
+    // Set while run() is inside main_loop::run(); read by the signal handler
+    std::atomic<services::main_loop*> running_loop{nullptr};
+
+    void on_signal(int)
+    {
+      if (auto* loop = running_loop.load())
+      {
+        loop->shutdown();
+      }
+    }
+
+    bool parse_action(const std::string& word,
+                      keyboard::InputEvent::Action& out)
+    {
+      if (word == "down")
+      {
+        out = keyboard::InputEvent::Action::Down;
+        return true;
+      }
+      if (word == "up")
+      {
+        out = keyboard::InputEvent::Action::Up;
+        return true;
+      }
+      return false;
+    }
+
+    // SDL mouse buttons: 1 left, 2 middle, 3 right, 4 X1, 5 X2
+    constexpr int kMaxMouseButton = 5;
+
+    // Parses one input script line. Returns false for unknown commands;
+    // 'sleep_ms' is set instead of 'ev' for a sleep.
+    bool parse_command(const std::string& line, keyboard::InputEvent& ev,
+                       int& sleep_ms)
+    {
+      std::istringstream in(line);
+      std::string command;
+      in >> command;
+      ev = keyboard::InputEvent{};
+      sleep_ms = 0;
+      if (command == "key" || command == "button")
+      {
+        int code = 0;
+        std::string action;
+        const int max_code = command == "key" ? 0xFFFF : kMaxMouseButton;
+        if (!(in >> code >> action) || code <= 0 || code > max_code ||
+            !parse_action(action, ev.action))
+        {
+          return false;
+        }
+        ev.type = command == "key" ? keyboard::InputEvent::Type::Key
+                                   : keyboard::InputEvent::Type::Mouse;
+        ev.code = static_cast<uint16_t>(code);
+        return true;
+      }
+      if (command == "move" || command == "scroll")
+      {
+        ev.type = keyboard::InputEvent::Type::Mouse;
+        ev.action = command == "move" ? keyboard::InputEvent::Action::Move
+                                      : keyboard::InputEvent::Action::Scroll;
+        return static_cast<bool>(in >> ev.dx >> ev.dy);
+      }
+      if (command == "sleep")
+      {
+        return static_cast<bool>(in >> sleep_ms) && sleep_ms >= 0;
+      }
+      return false;
+    }
+
+    // Feeds stdin into 'flow' until it ends, then stops the main loop. The
+    // flow is shared so that a reader still blocked on stdin at shutdown
+    // never outlives it.
+    void read_script(std::shared_ptr<flows::SenderFlow> flow,
+                     services::main_loop* loop)
+    {
+      std::string line;
+      int line_number = 0;
+      while (std::getline(std::cin, line))
+      {
+        ++line_number;
+        const auto first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#')
+        {
+          continue;
+        }
+        keyboard::InputEvent ev{};
+        int sleep_ms = 0;
+        if (!parse_command(line, ev, sleep_ms))
+        {
+          KP_LOG_WARN("headless", "Skipping line " << line_number << ": "
+                                                   << line);
+          continue;
+        }
+        if (sleep_ms > 0)
+        {
+          std::this_thread::sleep_for(std::chrono::milliseconds(sleep_ms));
+          continue;
+        }
+        ev.timestamp_ns = utils::latency::now_ns();
+        flow->push_event(ev);
+      }
+      KP_LOG_INFO("headless", "End of input after " << line_number
+                                                    << " lines");
+      std::this_thread::sleep_for(kDrainDelay);
+      loop->shutdown();
+    }
+
+    // Receiver: inject what the sender sends. Without a peer address the
+    // first sender to ask becomes the pinned peer.
+    int run_receiver(const cli::Options& options,
+                     services::communication_service& communication,
+                     services::main_loop& loop)
+    {
+      flows::ReceiverFlow flow;
+      if (!flow.start())
+      {
+        KP_LOG_ERROR("headless", "Unable to start the receiver flow");
+        return 1;
+      }
+
+      using package_emitter = utils::event_emitter<services::typed_package>;
+      package_emitter::subscription_id subscription_id = 0;
+      const bool follow_sender = options.ip.empty();
+      if (!follow_sender)
+      {
+        communication.pin_connection(p2p::peer(options.ip));
+      }
+      else
+      {
+        // Called on the receive thread: pinning may join the previous
+        // client's thread, so it runs on the services thread instead, and
+        // only when the asking sender is not the one already pinned.
+        auto pinned_ip = std::make_shared<std::string>();
+        subscription_id = communication.on_package.subscribe(
+            [&communication, &loop,
+             pinned_ip](const services::typed_package& package)
+            {
+              if (!services::become_receiver_package::is(package))
+              {
+                return;
+              }
+              loop.post(
+                  [&communication, pinned_ip,
+                   ip = package.meta.get_from().get_ip_address()]
+                  {
+                    if (*pinned_ip == ip)
+                    {
+                      return;
+                    }
+                    KP_LOG_INFO("headless", "Becoming receiver for " << ip);
+                    communication.pin_connection(p2p::peer(ip));
+                    *pinned_ip = ip;
+                  });
+            });
+      }
+      KP_LOG_INFO("headless", "Receiving on port " << options.port);
+
+      running_loop.store(&loop);
+      loop.run();
+      running_loop.store(nullptr);
+
+      if (follow_sender)
+      {
+        communication.on_package.unsubscribe(subscription_id);
+      }
+      flow.stop();
+      return 0;
+    }
+
+    // Sender: ask the peer to become our receiver, then replay stdin.
+    int run_sender(const cli::Options& options,
+                   services::communication_service& communication,
+                   const services::discovery_service& discovery,
+                   services::main_loop& loop)
+    {
+      communication.pin_connection(p2p::peer(options.ip));
+
+      services::become_receiver_package become_receiver;
+      become_receiver.device_id = discovery.self_peer.device_id;
+      services::typed_package package;
+      package.type = services::become_receiver_package::type;
+      package.payload = become_receiver.encode();
+      communication.send_package_reliable(package);
+
+      auto flow = std::make_shared<flows::SenderFlow>();
+      flow->set_redundant_key_delivery(options.key_copies);
+      if (!flow->start())
+      {
+        KP_LOG_ERROR("headless", "Unable to start the sender flow");
+        return 1;
+      }
+      KP_LOG_INFO("headless", "Sending to " << options.ip << ":"
+                                            << options.port);
+
+      // Not joined: at shutdown it may still be blocked on stdin
+      std::thread(read_script, flow, &loop).detach();
+
+      running_loop.store(&loop);
+      loop.run();
+      running_loop.store(nullptr);
+
+      flow->stop();
+      return 0;
+    }
+  } // namespace
+
+  int run(const cli::Options& options)
+  {
+    p2p::transport_kind kind = p2p::transport_kind::enet;
+    if (!p2p::transport_kind_from_name(options.transport, kind) ||
+        kind == p2p::transport_kind::loopback)
+    {
+      std::cerr << "Unknown transport: " << options.transport << std::endl;
+      return 1;
+    }
+
+    auto& locator = services::service_locator::instance();
+    locator.main_loop = std::make_unique<services::main_loop>(false);
+    auto& loop = *locator.main_loop;
+
+    // Both modes announce themselves: GUI senders list headless receivers
+    // among their discovered devices, and GUI receivers match a headless
+    // sender's become_receiver request against theirs
+    auto discovery = std::make_shared<services::discovery_service>();
+    locator.repository.add_service(discovery);
+
+    auto communication =
+        std::make_shared<services::communication_service>(kind);
+    communication->set_port(options.port);
+    locator.repository.add_service(communication);
+
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+
+    loop.init();
+    const int code = options.mode == "sender"
+                         ? run_sender(options, *communication, *discovery, loop)
+                         : run_receiver(options, *communication, loop);
+    loop.cleanup();
+    utils::log::flush();
+    return code;
+  }
+} // namespace headless
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "utils/cli/args.h"
+
+namespace headless
+{
+  // Runs keyleport without a window, as set up by cli::parse(): the
+  // services and one input flow, until SIGINT/SIGTERM. Returns the process
+  // exit code.
+  //
+  // A receiver listens on options.port and injects whatever its sender
+  // sends; without --ip it pins the first sender that asks it to become a
+  // receiver. A sender connects to options.ip and, having no window to
+  // capture from, reads input commands from stdin, one per line:
+  //
+  //   key <scancode> down|up
+  //   button <1-5> down|up
+  //   move <dx> <dy>
+  //   scroll <dx> <dy>
+  //   sleep <ms>
+  //
+  // Blank lines and lines starting with '#' are skipped. At the end of
+  // stdin the sender lets the last events go out and exits.
+  int run(const cli::Options& options);
+} // namespace headless
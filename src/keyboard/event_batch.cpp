@@ -1,59 +1,295 @@
 #include "event_batch.h"
 
-#include <nlohmann/json.hpp>
+#include "utils/byte_order/byte_order.h"
+#include "utils/serialization/varint.h"
+
+#include <utility>
 
 namespace keyboard
 {
 
-  std::string EventBatch::encode() const
+  namespace
+  {
+    using utils::serialization::get_varint;
+    using utils::serialization::put_varint;
+    using utils::serialization::unzigzag;
+    using utils::serialization::varint_size;
+    using utils::serialization::zigzag;
+
+    constexpr size_t kFixedHeaderSize = 4;
+    constexpr size_t kTimestampHeaderSize = 8;
+    constexpr uint64_t kNsPerUs = 1000;
+
+    inline bool has_code(InputEvent::Action action)
+    {
+      return action == InputEvent::Action::Down ||
+             action == InputEvent::Action::Up;
+    }
+
+    inline int64_t timestamp_delta_us(const InputEvent& e, uint64_t base_ns)
+    {
+      return static_cast<int64_t>(e.timestamp_ns - base_ns) /
+             static_cast<int64_t>(kNsPerUs);
+    }
+
+    inline bool same_run(const InputEvent& a, const InputEvent& b)
+    {
+      return a.type == b.type && a.action == b.action;
+    }
+
+    inline uint8_t run_tag(const InputEvent& e, size_t run_length)
+    {
+      return static_cast<uint8_t>((static_cast<uint8_t>(e.type) & 0x01) |
+                                  ((static_cast<uint8_t>(e.action) & 0x03)
+                                   << 1) |
+                                  ((run_length - 1) << 3));
+    }
+
+    size_t event_body_size(const InputEvent& e, bool with_timestamps,
+                           uint64_t base_ns)
+    {
+      size_t n = 0;
+      if (has_code(e.action))
+      {
+        n += varint_size(e.code);
+      }
+      n += varint_size(zigzag(e.dx));
+      n += varint_size(zigzag(e.dy));
+      if (with_timestamps)
+      {
+        n += varint_size(zigzag(timestamp_delta_us(e, base_ns)));
+      }
+      return n;
+    }
+
+    size_t put_event_body(uint8_t* out, const InputEvent& e,
+                          bool with_timestamps, uint64_t base_ns)
+    {
+      size_t n = 0;
+      if (has_code(e.action))
+      {
+        n += put_varint(out + n, e.code);
+      }
+      n += put_varint(out + n, zigzag(e.dx));
+      n += put_varint(out + n, zigzag(e.dy));
+      if (with_timestamps)
+      {
+        n += put_varint(out + n, zigzag(timestamp_delta_us(e, base_ns)));
+      }
+      return n;
+    }
+
+    // Length of the run of same type/action events starting at 'begin'
+    size_t run_length_at(const std::vector<InputEvent>& events, size_t begin)
+    {
+      size_t len = 1;
+      while (begin + len < events.size() && len < EventBatch::kMaxRunLength &&
+             same_run(events[begin], events[begin + len]))
+      {
+        ++len;
+      }
+      return len;
+    }
+  } // namespace
+
+  size_t EventBatch::header_size() const noexcept
+  {
+    return kFixedHeaderSize + (with_timestamps ? kTimestampHeaderSize : 0);
+  }
+
+  size_t EventBatch::encoded_size() const noexcept
   {
-    nlohmann::json j;
-    j["events"] = nlohmann::json::array();
-    for (const auto& e : events)
+    const uint64_t base_ns = events.empty() ? 0 : events.front().timestamp_ns;
+    size_t total = header_size();
+    for (size_t i = 0; i < events.size();)
     {
-      j["events"].push_back({{"type", static_cast<int>(e.type)},
-                             {"action", static_cast<int>(e.action)},
-                             {"code", static_cast<int>(e.code)},
-                             {"dx", e.dx},
-                             {"dy", e.dy}});
+      const size_t len = run_length_at(events, i);
+      total += 1; // run tag
+      for (size_t k = 0; k < len; ++k)
+      {
+        total += event_body_size(events[i + k], with_timestamps, base_ns);
+      }
+      i += len;
     }
-    return j.dump();
+    return total;
   }
 
-  EventBatch EventBatch::decode(const std::string& s)
+  size_t EventBatch::encode(uint8_t* out, size_t cap) const
   {
-    EventBatch batch;
-    auto j = nlohmann::json::parse(s, nullptr, false);
-    if (!j.is_object())
+    if (!out || events.size() > kMaxEvents || cap < encoded_size())
     {
-      return batch;
+      return 0;
     }
-    auto it = j.find("events");
-    if (it == j.end() || !it->is_array())
+    const uint64_t base_ns = events.empty() ? 0 : events.front().timestamp_ns;
+
+    out[0] = kVersion;
+    out[1] = with_timestamps ? kFlagTimestamps : 0;
+    utils::byte_order::put_u16(out + 2, static_cast<uint16_t>(events.size()));
+    size_t pos = kFixedHeaderSize;
+    if (with_timestamps)
     {
-      return batch;
+      utils::byte_order::put_u64(out + pos, base_ns);
+      pos += kTimestampHeaderSize;
     }
-    for (const auto& je : *it)
+
+    for (size_t i = 0; i < events.size();)
     {
-      if (!je.is_object())
+      const size_t len = run_length_at(events, i);
+      out[pos++] = run_tag(events[i], len);
+      for (size_t k = 0; k < len; ++k)
       {
-        continue;
+        pos += put_event_body(out + pos, events[i + k], with_timestamps,
+                              base_ns);
+      }
+      i += len;
+    }
+    return pos;
+  }
+
+  std::string EventBatch::encode() const
+  {
+    std::string out(encoded_size(), '\0');
+    const size_t n = encode(reinterpret_cast<uint8_t*>(&out[0]), out.size());
+    out.resize(n);
+    return out;
+  }
+
+  bool EventBatch::decode(const uint8_t* data, size_t size, EventBatch& out)
+  {
+    out.events.clear();
+    out.with_timestamps = false;
+    if (!data || size < kFixedHeaderSize || data[0] != kVersion)
+    {
+      return false;
+    }
+    out.with_timestamps = (data[1] & kFlagTimestamps) != 0;
+    const size_t count = utils::byte_order::get_u16(data + 2);
+    size_t pos = kFixedHeaderSize;
+    uint64_t base_ns = 0;
+    if (out.with_timestamps)
+    {
+      if (size < pos + kTimestampHeaderSize)
+      {
+        return false;
       }
-      InputEvent e{};
-      e.type = static_cast<InputEvent::Type>(je.value("type", 0));
-      e.action = static_cast<InputEvent::Action>(je.value("action", 0));
-      e.code = static_cast<uint16_t>(je.value("code", 0));
-      e.dx = je.value("dx", 0);
-      e.dy = je.value("dy", 0);
-      // Back-compat: if payload uses legacy 'delta' for vertical scroll, map it
-      // to dy
-      if (e.action == InputEvent::Action::Scroll && e.dy == 0)
+      base_ns = utils::byte_order::get_u64(data + pos);
+      pos += kTimestampHeaderSize;
+    }
+
+    out.events.reserve(count);
+    while (out.events.size() < count)
+    {
+      if (pos >= size)
       {
-        e.dy = je.value("delta", 0);
+        return false;
+      }
+      const uint8_t tag = data[pos++];
+      const uint8_t action = (tag >> 1) & 0x03;
+      const size_t len = static_cast<size_t>(tag >> 3) + 1;
+      if (out.events.size() + len > count)
+      {
+        return false;
+      }
+      for (size_t k = 0; k < len; ++k)
+      {
+        InputEvent e{};
+        e.type = static_cast<InputEvent::Type>(tag & 0x01);
+        e.action = static_cast<InputEvent::Action>(action);
+        uint64_t v = 0;
+        if (has_code(e.action))
+        {
+          if (!get_varint(data, size, pos, v) || v > 0xFFFF)
+          {
+            return false;
+          }
+          e.code = static_cast<uint16_t>(v);
+        }
+        if (!get_varint(data, size, pos, v))
+        {
+          return false;
+        }
+        e.dx = static_cast<int32_t>(unzigzag(v));
+        if (!get_varint(data, size, pos, v))
+        {
+          return false;
+        }
+        e.dy = static_cast<int32_t>(unzigzag(v));
+        if (out.with_timestamps)
+        {
+          if (!get_varint(data, size, pos, v))
+          {
+            return false;
+          }
+          e.timestamp_ns = base_ns + static_cast<uint64_t>(unzigzag(v)) *
+                                         kNsPerUs;
+        }
+        out.events.push_back(e);
       }
-      batch.events.push_back(e);
     }
+    return true;
+  }
+
+  EventBatch EventBatch::decode(const std::string& bytes)
+  {
+    EventBatch batch;
+    decode(reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size(),
+           batch);
     return batch;
   }
 
+  EventBatchPacker::EventBatchPacker(sink_t sink, size_t budget_bytes,
+                                     bool with_timestamps)
+      : sink_(std::move(sink)), budget_(budget_bytes)
+  {
+    batch_.with_timestamps = with_timestamps;
+    reset();
+  }
+
+  void EventBatchPacker::push(const InputEvent& event)
+  {
+    for (;;)
+    {
+      const bool empty = batch_.empty();
+      const uint64_t base_ns =
+          empty ? event.timestamp_ns : batch_.events.front().timestamp_ns;
+      const bool new_run = empty || run_length_ >= EventBatch::kMaxRunLength ||
+                           !same_run(batch_.events.back(), event);
+      const size_t cost = (new_run ? 1 : 0) +
+                          event_body_size(event, batch_.with_timestamps,
+                                          base_ns);
+
+      const bool full = batch_.size() >= EventBatch::kMaxEvents;
+      if (!empty && (full || size_ + cost > budget_))
+      {
+        flush();
+        continue;
+      }
+
+      batch_.push_back(event);
+      size_ += cost;
+      run_length_ = new_run ? 1 : run_length_ + 1;
+      return;
+    }
+  }
+
+  void EventBatchPacker::flush()
+  {
+    if (batch_.empty())
+    {
+      return;
+    }
+    if (sink_)
+    {
+      sink_(batch_);
+    }
+    reset();
+  }
+
+  void EventBatchPacker::reset()
+  {
+    batch_.clear();
+    size_ = batch_.header_size();
+    run_length_ = 0;
+  }
+
 } // namespace keyboard
@@ -2,21 +2,60 @@
 
 #include "input_event.h"
 
-#include <nlohmann/json.hpp>
-#include <sstream>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <string>
 #include <vector>
 
 namespace keyboard
 {
 
+  // A group of input events shipped in a single datagram.
+  //
+  // Wire format (version 1):
+  //   header:
+  //     u8  version
+  //     u8  flags (bit 0: per-event timestamps present)
+  //     u16 event count (little-endian)
+  //     u64 base timestamp_ns (only when timestamps are present)
+  //   runs, each introduced by a tag byte:
+  //     bit 0     type
+  //     bits 1..2 action
+  //     bits 3..7 run length - 1 (runs hold 1..32 events of the same
+  //               type/action)
+  //   per event in a run:
+  //     varint    code (Down/Up only; Move/Scroll carry no code)
+  //     zz-varint dx, dy
+  //     zz-varint timestamp delta from base in microseconds (when present)
+  //
+  // Sequence numbers are not carried; decoded events have seq == 0.
   struct EventBatch
   {
+    static constexpr uint8_t kVersion = 1;
+    static constexpr uint8_t kFlagTimestamps = 0x01;
+    static constexpr size_t kMaxEvents = 0xFFFF;
+    static constexpr size_t kMaxRunLength = 32;
+    // Largest possible encoding of one event including a fresh run tag
+    static constexpr size_t kMaxEventSize = 1 + 3 + 5 + 5 + 10;
+
     std::vector<InputEvent> events;
+    bool with_timestamps = false;
+
+    // Size of the header for the current flags.
+    size_t header_size() const noexcept;
+    // Exact size encode() would produce.
+    size_t encoded_size() const noexcept;
 
+    // Encode into a caller-provided buffer. Returns bytes written, or 0 when
+    // the buffer is too small or the batch holds too many events.
+    size_t encode(uint8_t* out, size_t cap) const;
     std::string encode() const;
 
-    static EventBatch decode(const std::string& json);
+    // Decode from raw bytes. Returns false on malformed input; 'out' is
+    // cleared first either way.
+    static bool decode(const uint8_t* data, size_t size, EventBatch& out);
+    static EventBatch decode(const std::string& bytes);
 
     // Convenience vector-like API for seamless adoption
     inline bool empty() const noexcept { return events.empty(); }
@@ -25,4 +64,35 @@ namespace keyboard
     inline void push_back(const InputEvent& event) { events.push_back(event); }
   };
 
+  // Accumulates events into EventBatch instances that encode to at most
+  // `budget_bytes` each. When the next event would overflow the budget the
+  // current batch is handed to the sink and a new one is started.
+  class EventBatchPacker
+  {
+  public:
+    using sink_t = std::function<void(const EventBatch&)>;
+
+    // A typical safe UDP payload on Ethernet/Wi-Fi without fragmentation
+    static constexpr size_t kDefaultBudgetBytes = 1200;
+
+    EventBatchPacker(sink_t sink, size_t budget_bytes = kDefaultBudgetBytes,
+                     bool with_timestamps = true);
+
+    void push(const InputEvent& event);
+    // Hand the pending batch (if any) to the sink.
+    void flush();
+
+    bool empty() const noexcept { return batch_.empty(); }
+    size_t pending_bytes() const noexcept { return size_; }
+
+  private:
+    sink_t sink_;
+    size_t budget_;
+    EventBatch batch_;
+    size_t size_{0};
+    size_t run_length_{0};
+
+    void reset();
+  };
+
 } // namespace keyboard
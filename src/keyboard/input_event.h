@@ -1,5 +1,8 @@
 #pragma once
 
+#include "utils/byte_order/byte_order.h"
+
+#include <cstddef>
 #include <cstdint>
 #include <nlohmann/json.hpp>
 #include <string>
@@ -32,10 +35,18 @@ namespace keyboard
     uint16_t code; // keycode
     int32_t dx;    // relative movement x (for mouse move/scroll)
     int32_t dy;    // relative movement y (for mouse move/scroll)
+    uint32_t seq;  // per-stream sequence number (0 when unused)
+    // Last motion frame sent before this event; the receiver applies that
+    // frame first (0 when there is nothing to wait for).
+    uint32_t motion_seq;
+    uint64_t timestamp_ns; // capture time, utils::latency::now_ns() clock
+                           // (0 when unknown)
 
     // Convert an SDL_Event to our InputEvent representation.
     // For unmapped events, returns a zero-initialized InputEvent.
     static InputEvent fromSDL(const SDL_Event& e);
+    // True for the SDL event types fromSDL() maps.
+    static bool isInputSDL(const SDL_Event& e);
   };
 
   // JSON converter for a single InputEvent
@@ -56,20 +67,106 @@ namespace keyboard
     static inline InputEvent decode(const std::string& s)
     {
       InputEvent e{};
-      auto j = nlohmann::json::parse(s, nullptr, false);
+      decode(s, e);
+      return e;
+    }
 
+    // Returns false (leaving 'out' untouched) unless 's' is a JSON object
+    // with in-range type and action.
+    static inline bool decode(const std::string& s, InputEvent& out)
+    {
+      auto j = nlohmann::json::parse(s, nullptr, false);
       if (!j.is_object())
       {
-        return e;
+        return false;
+      }
+      const int type = j.value("type", 0);
+      const int action = j.value("action", 0);
+      if (type < 0 || type > static_cast<int>(InputEvent::Type::Mouse) ||
+          action < 0 || action > static_cast<int>(InputEvent::Action::Scroll))
+      {
+        return false;
       }
 
-      e.type = static_cast<InputEvent::Type>(j.value("type", 0));
-      e.action = static_cast<InputEvent::Action>(j.value("action", 0));
+      InputEvent e{};
+      e.type = static_cast<InputEvent::Type>(type);
+      e.action = static_cast<InputEvent::Action>(action);
       e.code = static_cast<uint16_t>(j.value("code", 0));
       e.dx = j.value("dx", 0);
       e.dy = j.value("dy", 0);
+      out = e;
+      return true;
+    }
+  };
 
-      return e;
+  // Fixed-layout little-endian binary codec for a single InputEvent.
+  //
+  // Layout (version 1, 30 bytes):
+  //   [0]      u8  version
+  //   [1]      u8  type
+  //   [2]      u8  action
+  //   [3]      u8  reserved (0)
+  //   [4..5]   u16 code
+  //   [6..9]   i32 dx
+  //   [10..13] i32 dy
+  //   [14..17] u32 seq
+  //   [18..25] u64 timestamp_ns
+  //   [26..29] u32 motion_seq (absent from older 26-byte encodings)
+  //
+  // Fields may only be appended within a version; decoders ignore trailing
+  // bytes they do not know about and default missing appended fields to 0.
+  struct InputEventBinaryConverter
+  {
+    static constexpr uint8_t kVersion = 1;
+    static constexpr size_t kEncodedSize = 30;
+    // Size before motion_seq was appended
+    static constexpr size_t kMinEncodedSize = 26;
+
+    // Encode into a caller-provided buffer. Returns bytes written, or 0 when
+    // the buffer is too small.
+    static inline size_t encode(const InputEvent& e, uint8_t* out, size_t cap)
+    {
+      namespace bo = utils::byte_order;
+      if (!out || cap < kEncodedSize)
+      {
+        return 0;
+      }
+      out[0] = kVersion;
+      out[1] = static_cast<uint8_t>(e.type);
+      out[2] = static_cast<uint8_t>(e.action);
+      out[3] = 0;
+      bo::put_u16(out + 4, e.code);
+      bo::put_u32(out + 6, static_cast<uint32_t>(e.dx));
+      bo::put_u32(out + 10, static_cast<uint32_t>(e.dy));
+      bo::put_u32(out + 14, e.seq);
+      bo::put_u64(out + 18, e.timestamp_ns);
+      bo::put_u32(out + 26, e.motion_seq);
+      return kEncodedSize;
+    }
+
+    // Decode from raw bytes. Returns false (leaving 'out' untouched) on a
+    // short buffer, unknown version or out-of-range enum values.
+    static inline bool decode(const uint8_t* data, size_t size, InputEvent& out)
+    {
+      namespace bo = utils::byte_order;
+      if (!data || size < kMinEncodedSize || data[0] != kVersion)
+      {
+        return false;
+      }
+      if (data[1] > static_cast<uint8_t>(InputEvent::Type::Mouse) ||
+          data[2] > static_cast<uint8_t>(InputEvent::Action::Scroll))
+      {
+        return false;
+      }
+      out.type = static_cast<InputEvent::Type>(data[1]);
+      out.action = static_cast<InputEvent::Action>(data[2]);
+      out.code = bo::get_u16(data + 4);
+      out.dx = static_cast<int32_t>(bo::get_u32(data + 6));
+      out.dy = static_cast<int32_t>(bo::get_u32(data + 10));
+      out.seq = bo::get_u32(data + 14);
+      out.timestamp_ns = bo::get_u64(data + 18);
+      out.motion_seq = size >= kEncodedSize ? bo::get_u32(data + 26) : 0;
+      return true;
     }
   };
 
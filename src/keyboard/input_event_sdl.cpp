@@ -1,5 +1,7 @@
 #include "input_event.h"
 
+#include "utils/latency/latency.h"
+
 #include <SDL3/SDL.h>
 
 namespace keyboard
@@ -50,7 +52,18 @@ namespace keyboard
     return ev;
   }
 
-  InputEvent InputEvent::fromSDL(const SDL_Event& e)
+  // SDL stamps events with SDL_GetTicksNS() time; rebase onto steady_clock
+  // so latency stages share one clock.
+  static inline uint64_t capture_time_ns(const SDL_Event& e)
+  {
+    const uint64_t sdl_now = SDL_GetTicksNS();
+    const uint64_t steady_now = utils::latency::now_ns();
+    const uint64_t age =
+        sdl_now > e.common.timestamp ? sdl_now - e.common.timestamp : 0;
+    return steady_now > age ? steady_now - age : steady_now;
+  }
+
+  static inline InputEvent map_sdl_event(const SDL_Event& e)
   {
     switch (e.type)
     {
@@ -78,4 +91,30 @@ namespace keyboard
     return InputEvent{}; // unknown/unhandled
   }
 
+  InputEvent InputEvent::fromSDL(const SDL_Event& e)
+  {
+    InputEvent ev = map_sdl_event(e);
+    if (isInputSDL(e))
+    {
+      ev.timestamp_ns = capture_time_ns(e);
+    }
+    return ev;
+  }
+
+  bool InputEvent::isInputSDL(const SDL_Event& e)
+  {
+    switch (e.type)
+    {
+    case SDL_EVENT_KEY_DOWN:
+    case SDL_EVENT_KEY_UP:
+    case SDL_EVENT_MOUSE_MOTION:
+    case SDL_EVENT_MOUSE_WHEEL:
+    case SDL_EVENT_MOUSE_BUTTON_DOWN:
+    case SDL_EVENT_MOUSE_BUTTON_UP:
+      return true;
+    default:
+      return false;
+    }
+  }
+
 } // namespace keyboard
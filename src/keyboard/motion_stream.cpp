@@ -0,0 +1,221 @@
+#include "motion_stream.h"
+
+#include "utils/byte_order/byte_order.h"
+#include "utils/serialization/varint.h"
+
+#include <random>
+
+namespace keyboard
+{
+
+  namespace
+  {
+    using utils::serialization::get_varint;
+    using utils::serialization::put_varint;
+    using utils::serialization::unzigzag;
+    using utils::serialization::varint_size;
+    using utils::serialization::zigzag;
+
+    constexpr size_t kHeaderSize = 1 + 4 + 4;
+
+    uint32_t random_stream_id()
+    {
+      std::random_device rd;
+      uint32_t id = 0;
+      while (id == 0)
+      {
+        id = static_cast<uint32_t>(rd());
+      }
+      return id;
+    }
+
+    // Serial number arithmetic (RFC 1982) on 32-bit sequence numbers
+    inline int32_t seq_distance(uint32_t from, uint32_t to)
+    {
+      return static_cast<int32_t>(to - from);
+    }
+
+    inline bool get_i32(const uint8_t* data, size_t size, size_t& pos,
+                        int32_t& v)
+    {
+      uint64_t raw = 0;
+      if (!get_varint(data, size, pos, raw))
+      {
+        return false;
+      }
+      const int64_t s = unzigzag(raw);
+      if (s < INT32_MIN || s > INT32_MAX)
+      {
+        return false;
+      }
+      v = static_cast<int32_t>(s);
+      return true;
+    }
+  } // namespace
+
+  size_t MotionFrame::encode(uint8_t* out, size_t cap) const
+  {
+    namespace bo = utils::byte_order;
+    size_t need = kHeaderSize;
+    for (const auto& c : channels)
+    {
+      need += 8 + varint_size(zigzag(c.dx)) + varint_size(zigzag(c.dy));
+    }
+    if (!out || cap < need)
+    {
+      return 0;
+    }
+
+    out[0] = kVersion;
+    bo::put_u32(out + 1, stream_id);
+    bo::put_u32(out + 5, seq);
+    size_t pos = kHeaderSize;
+    for (const auto& c : channels)
+    {
+      bo::put_u32(out + pos, c.total_dx);
+      bo::put_u32(out + pos + 4, c.total_dy);
+      pos += 8;
+      pos += put_varint(out + pos, zigzag(c.dx));
+      pos += put_varint(out + pos, zigzag(c.dy));
+    }
+    return pos;
+  }
+
+  std::string MotionFrame::encode() const
+  {
+    uint8_t buf[kMaxEncodedSize];
+    const size_t n = encode(buf, sizeof(buf));
+    return std::string(reinterpret_cast<const char*>(buf), n);
+  }
+
+  bool MotionFrame::decode(const uint8_t* data, size_t size, MotionFrame& out)
+  {
+    namespace bo = utils::byte_order;
+    if (!data || size < kHeaderSize || data[0] != kVersion)
+    {
+      return false;
+    }
+    MotionFrame f;
+    f.stream_id = bo::get_u32(data + 1);
+    f.seq = bo::get_u32(data + 5);
+    size_t pos = kHeaderSize;
+    for (auto& c : f.channels)
+    {
+      if (size < pos + 8)
+      {
+        return false;
+      }
+      c.total_dx = bo::get_u32(data + pos);
+      c.total_dy = bo::get_u32(data + pos + 4);
+      pos += 8;
+      if (!get_i32(data, size, pos, c.dx) || !get_i32(data, size, pos, c.dy))
+      {
+        return false;
+      }
+    }
+    out = f;
+    return true;
+  }
+
+  bool MotionFrame::decode(const std::string& bytes, MotionFrame& out)
+  {
+    return decode(reinterpret_cast<const uint8_t*>(bytes.data()),
+                  bytes.size(), out);
+  }
+
+  MotionStreamWriter::MotionStreamWriter() : stream_id_(random_stream_id())
+  {
+  }
+
+  MotionFrame MotionStreamWriter::next(const MotionDeltas& deltas)
+  {
+    MotionFrame f;
+    f.stream_id = stream_id_;
+    f.seq = ++seq_;
+    for (size_t i = 0; i < MotionFrame::ChannelCount; ++i)
+    {
+      auto& total = totals_[i];
+      total.total_dx += static_cast<uint32_t>(deltas[i].dx);
+      total.total_dy += static_cast<uint32_t>(deltas[i].dy);
+
+      auto& c = f.channels[i];
+      c.dx = deltas[i].dx;
+      c.dy = deltas[i].dy;
+      c.total_dx = total.total_dx;
+      c.total_dy = total.total_dy;
+    }
+    return f;
+  }
+
+  bool MotionStreamReader::accept(const MotionFrame& frame, MotionDeltas& out)
+  {
+    if (joined_ && frame.stream_id == stream_id_)
+    {
+      const int32_t ahead = seq_distance(last_seq_, frame.seq);
+      if (ahead <= 0)
+      {
+        ++stats_.stale;
+        return false;
+      }
+      stats_.recovered += static_cast<uint64_t>(ahead - 1);
+      for (size_t i = 0; i < MotionFrame::ChannelCount; ++i)
+      {
+        const auto& c = frame.channels[i];
+        out[i].dx = static_cast<int32_t>(c.total_dx - totals_[i].total_dx);
+        out[i].dy = static_cast<int32_t>(c.total_dy - totals_[i].total_dy);
+      }
+    }
+    else
+    {
+      // A late frame from the stream we just left must not rejoin it
+      if (frame.stream_id == 0 || frame.stream_id == retired_stream_id_)
+      {
+        ++stats_.stale;
+        return false;
+      }
+      if (joined_)
+      {
+        retired_stream_id_ = stream_id_;
+      }
+      joined_ = true;
+      stream_id_ = frame.stream_id;
+      ++stats_.streams;
+      // Near the start of a stream the totals are all travel since the
+      // sender began, so lost leading frames are rebuilt too. Later on they
+      // include travel from before we listened; take only this frame's.
+      const bool from_start = frame.seq <= MotionFrame::kStartWindow;
+      for (size_t i = 0; i < MotionFrame::ChannelCount; ++i)
+      {
+        const auto& c = frame.channels[i];
+        out[i].dx = from_start ? static_cast<int32_t>(c.total_dx) : c.dx;
+        out[i].dy = from_start ? static_cast<int32_t>(c.total_dy) : c.dy;
+      }
+      if (from_start)
+      {
+        stats_.recovered += frame.seq - 1;
+      }
+    }
+
+    last_seq_ = frame.seq;
+    for (size_t i = 0; i < MotionFrame::ChannelCount; ++i)
+    {
+      totals_[i].total_dx = frame.channels[i].total_dx;
+      totals_[i].total_dy = frame.channels[i].total_dy;
+    }
+    ++stats_.applied;
+    return true;
+  }
+
+  void MotionStreamReader::reset()
+  {
+    if (joined_)
+    {
+      retired_stream_id_ = stream_id_;
+    }
+    joined_ = false;
+    stream_id_ = 0;
+    last_seq_ = 0;
+    totals_ = {};
+  }
+
+} // namespace keyboard
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace keyboard
+{
+
+  // Loss-tolerant relative motion over an unreliable channel.
+  //
+  // Every frame carries, per motion channel, both its own delta and the
+  // running total of all deltas sent on the stream so far. A receiver that
+  // missed frames applies "total - last applied total" and so recovers the
+  // travel of every lost frame from the next one that arrives; a frame whose
+  // sequence number is not newer than the last applied one is stale or a
+  // duplicate and is dropped. A receiver joining within the first
+  // kStartWindow frames applies the totals as-is; one joining later only
+  // applies the frame's own delta, since the totals then include travel
+  // from before it was listening.
+  //
+  // Totals are 32-bit and wrap; differences are taken modulo 2^32, which is
+  // exact as long as less than 2^31 units of travel are lost in a row.
+  //
+  // Wire format (version 1):
+  //   u8  version
+  //   u32 stream id (random per sender session, never 0)
+  //   u32 sequence number (wrapping, compared with serial arithmetic)
+  //   per channel, in MotionFrame::Channel order:
+  //     u32       total dx, total dy
+  //     zz-varint dx, dy
+  struct MotionFrame
+  {
+    enum Channel : size_t
+    {
+      Move = 0,
+      Scroll = 1,
+      ChannelCount
+    };
+
+    struct Axis
+    {
+      int32_t dx = 0;
+      int32_t dy = 0;
+      uint32_t total_dx = 0;
+      uint32_t total_dy = 0;
+    };
+
+    static constexpr uint8_t kVersion = 1;
+    // Sequence numbers 1..kStartWindow count as the start of a stream
+    static constexpr uint32_t kStartWindow = 64;
+    static constexpr size_t kMaxEncodedSize =
+        1 + 4 + 4 + ChannelCount * (4 + 4 + 5 + 5);
+
+    uint32_t stream_id = 0;
+    uint32_t seq = 0;
+    std::array<Axis, ChannelCount> channels{};
+
+    // Encode into a caller-provided buffer. Returns bytes written, or 0 when
+    // the buffer is too small.
+    size_t encode(uint8_t* out, size_t cap) const;
+    std::string encode() const;
+
+    // Decode from raw bytes. Returns false on malformed input.
+    static bool decode(const uint8_t* data, size_t size, MotionFrame& out);
+    static bool decode(const std::string& bytes, MotionFrame& out);
+  };
+
+  struct MotionDelta
+  {
+    int32_t dx = 0;
+    int32_t dy = 0;
+
+    bool empty() const noexcept { return dx == 0 && dy == 0; }
+  };
+
+  using MotionDeltas = std::array<MotionDelta, MotionFrame::ChannelCount>;
+
+  // Sender half: numbers frames and keeps the running totals.
+  class MotionStreamWriter
+  {
+  public:
+    // A fresh writer starts a new stream with a random id.
+    MotionStreamWriter();
+
+    // Build the next frame for the given per-channel deltas.
+    MotionFrame next(const MotionDeltas& deltas);
+
+    uint32_t stream_id() const noexcept { return stream_id_; }
+    // Sequence number of the last frame built; 0 before the first.
+    uint32_t last_seq() const noexcept { return seq_; }
+
+  private:
+    uint32_t stream_id_;
+    uint32_t seq_{0};
+    std::array<MotionFrame::Axis, MotionFrame::ChannelCount> totals_{};
+  };
+
+  // Receiver half: turns frames, in arrival order, into the deltas to apply.
+  class MotionStreamReader
+  {
+  public:
+    struct Stats
+    {
+      uint64_t applied = 0;   // frames that produced deltas
+      uint64_t recovered = 0; // lost frames whose travel was rebuilt
+      uint64_t stale = 0;     // duplicate, reordered or retired-stream frames
+      uint64_t streams = 0;   // streams joined
+    };
+
+    // Returns false when the frame must be dropped; otherwise 'out' holds
+    // the deltas to apply (possibly zero).
+    bool accept(const MotionFrame& frame, MotionDeltas& out);
+    // Forget the current stream, e.g. when the sender disconnects.
+    void reset();
+
+    // True once frame 'seq' of the current stream has been applied or
+    // recovered, i.e. a frame at least as new has been accepted.
+    bool covers(uint32_t seq) const noexcept
+    {
+      return joined_ && static_cast<int32_t>(last_seq_ - seq) >= 0;
+    }
+
+    const Stats& stats() const noexcept { return stats_; }
+
+  private:
+    bool joined_{false};
+    uint32_t stream_id_{0};
+    uint32_t retired_stream_id_{0};
+    uint32_t last_seq_{0};
+    std::array<MotionFrame::Axis, MotionFrame::ChannelCount> totals_{};
+    Stats stats_;
+  };
+
+} // namespace keyboard
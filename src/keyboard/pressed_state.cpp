@@ -0,0 +1,132 @@
+#include "pressed_state.h"
+
+#include "utils/byte_order/byte_order.h"
+#include "utils/serialization/varint.h"
+
+namespace keyboard
+{
+
+  namespace
+  {
+    using utils::serialization::get_varint;
+    using utils::serialization::put_varint;
+
+    constexpr size_t kHeaderSize = 1 + 4;
+
+    template <size_t N>
+    void put_codes(std::string& out, const std::bitset<N>& bits)
+    {
+      uint8_t buf[utils::serialization::kMaxVarintSize];
+      out.append(reinterpret_cast<const char*>(buf),
+                 put_varint(buf, bits.count()));
+      size_t prev = 0;
+      for (size_t code = 0; code < N; ++code)
+      {
+        if (bits[code])
+        {
+          out.append(reinterpret_cast<const char*>(buf),
+                     put_varint(buf, code - prev));
+          prev = code;
+        }
+      }
+    }
+
+    template <size_t N>
+    bool get_codes(const uint8_t* data, size_t size, size_t& pos,
+                   std::bitset<N>& bits)
+    {
+      uint64_t count = 0;
+      if (!get_varint(data, size, pos, count) || count > N)
+      {
+        return false;
+      }
+      uint64_t code = 0;
+      for (uint64_t i = 0; i < count; ++i)
+      {
+        uint64_t gap = 0;
+        if (!get_varint(data, size, pos, gap) || gap >= N ||
+            (i > 0 && gap == 0) || code + gap >= N)
+        {
+          return false;
+        }
+        code += gap;
+        bits.set(static_cast<size_t>(code));
+      }
+      return true;
+    }
+  } // namespace
+
+  bool PressedState::apply(const InputEvent& ev)
+  {
+    if (ev.action != InputEvent::Action::Down &&
+        ev.action != InputEvent::Action::Up)
+    {
+      return false;
+    }
+    const bool down = ev.action == InputEvent::Action::Down;
+    if (ev.type == InputEvent::Type::Key && ev.code < kMaxKeyCode)
+    {
+      const bool changed = keys_[ev.code] != down;
+      keys_[ev.code] = down;
+      return changed;
+    }
+    if (ev.type == InputEvent::Type::Mouse && ev.code < kMaxButtonCode)
+    {
+      const bool changed = buttons_[ev.code] != down;
+      buttons_[ev.code] = down;
+      return changed;
+    }
+    return false;
+  }
+
+  bool PressedState::pressed(InputEvent::Type type, uint16_t code) const
+  {
+    if (type == InputEvent::Type::Key)
+    {
+      return code < kMaxKeyCode && keys_[code];
+    }
+    return code < kMaxButtonCode && buttons_[code];
+  }
+
+  void PressedState::clear()
+  {
+    keys_.reset();
+    buttons_.reset();
+  }
+
+  std::string PressedStateSync::encode() const
+  {
+    std::string out(kHeaderSize, '\0');
+    out[0] = static_cast<char>(kVersion);
+    utils::byte_order::put_u32(reinterpret_cast<uint8_t*>(&out[1]), seq);
+    put_codes(out, state.keys_);
+    put_codes(out, state.buttons_);
+    return out;
+  }
+
+  bool PressedStateSync::decode(const uint8_t* data, size_t size,
+                                PressedStateSync& out)
+  {
+    if (!data || size < kHeaderSize || data[0] != kVersion)
+    {
+      return false;
+    }
+    PressedStateSync s;
+    s.seq = utils::byte_order::get_u32(data + 1);
+    size_t pos = kHeaderSize;
+    if (!get_codes(data, size, pos, s.state.keys_) ||
+        !get_codes(data, size, pos, s.state.buttons_))
+    {
+      return false;
+    }
+    out = s;
+    return true;
+  }
+
+  bool PressedStateSync::decode(const std::string& bytes, PressedStateSync& out)
+  {
+    return decode(reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size(),
+                  out);
+  }
+
+} // namespace keyboard
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "input_event.h"
+
+#include <bitset>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace keyboard
+{
+
+  // The set of keys and mouse buttons currently held down.
+  //
+  // Keys are indexed by scancode and buttons by SDL button number; codes
+  // outside the tracked ranges are ignored.
+  class PressedState
+  {
+  public:
+    static constexpr size_t kMaxKeyCode = 512; // SDL_SCANCODE_COUNT
+    static constexpr size_t kMaxButtonCode = 32;
+
+    // Track a Down/Up event. Returns true if the state changed; other
+    // actions and untracked codes leave it untouched.
+    bool apply(const InputEvent& ev);
+
+    bool pressed(InputEvent::Type type, uint16_t code) const;
+    bool empty() const { return keys_.none() && buttons_.none(); }
+    void clear();
+
+    // Calls fn(const InputEvent&) with the Up and Down events that turn this
+    // state into 'target': all releases first, then all presses.
+    template <typename F> void diff(const PressedState& target, F&& fn) const
+    {
+      for_each_change(target, InputEvent::Action::Up, fn);
+      for_each_change(target, InputEvent::Action::Down, fn);
+    }
+
+    bool operator==(const PressedState& other) const
+    {
+      return keys_ == other.keys_ && buttons_ == other.buttons_;
+    }
+    bool operator!=(const PressedState& other) const
+    {
+      return !(*this == other);
+    }
+
+  private:
+    friend struct PressedStateSync;
+
+    std::bitset<kMaxKeyCode> keys_;
+    std::bitset<kMaxButtonCode> buttons_;
+
+    template <typename F>
+    void for_each_change(const PressedState& target, InputEvent::Action action,
+                         F& fn) const
+    {
+      const bool down = action == InputEvent::Action::Down;
+      InputEvent ev{};
+      ev.action = action;
+      ev.type = InputEvent::Type::Key;
+      for (size_t code = 0; code < kMaxKeyCode; ++code)
+      {
+        if (keys_[code] != target.keys_[code] && target.keys_[code] == down)
+        {
+          ev.code = static_cast<uint16_t>(code);
+          fn(ev);
+        }
+      }
+      ev.type = InputEvent::Type::Mouse;
+      for (size_t code = 0; code < kMaxButtonCode; ++code)
+      {
+        if (buttons_[code] != target.buttons_[code] &&
+            target.buttons_[code] == down)
+        {
+          ev.code = static_cast<uint16_t>(code);
+          fn(ev);
+        }
+      }
+    }
+  };
+
+  // Periodic snapshot of the sender's PressedState, sent unreliably so that
+  // the receiver can repair keys left stuck or missing by a stalled or lost
+  // reliable key event.
+  //
+  // 'seq' is the InputEvent::seq of the last key/button event reflected in
+  // the snapshot. The receiver applies a snapshot only if it is at least as
+  // new as the last key event it applied, and then drops reliable events it
+  // already covers. Senders start seq at a random value each session so a
+  // restarted sender is recognised as a new stream.
+  //
+  // Wire format (version 1):
+  //   u8     version
+  //   u32    seq
+  //   varint pressed key count, then ascending key codes as varint gaps
+  //   varint pressed button count, then ascending button codes as gaps
+  struct PressedStateSync
+  {
+    static constexpr uint8_t kVersion = 1;
+    // Sender cadence; the snapshot doubles as a heartbeat.
+    static constexpr std::chrono::milliseconds kInterval{100};
+    // Receivers release everything after this many intervals of silence.
+    static constexpr int kMissedBeforeRelease = 3;
+
+    uint32_t seq = 0;
+    PressedState state;
+
+    std::string encode() const;
+    // Returns false on malformed input.
+    static bool decode(const uint8_t* data, size_t size, PressedStateSync& out);
+    static bool decode(const std::string& bytes, PressedStateSync& out);
+  };
+
+} // namespace keyboard
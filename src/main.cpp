@@ -1,11 +1,33 @@
+#include "headless/headless.h"
 #include "services/main_loop/main_loop.h"
 #include "services/service_locator.h"
 #include "store.h"
+#include "utils/cli/args.h"
+
+#include <iostream>
 
 int main(int argc, char* argv[])
 {
   store::init();
 
+  // Any argument selects headless mode; none opens the window
+  if (argc > 1)
+  {
+    const cli::Options options = cli::parse(argc, argv);
+    if (options.help)
+    {
+      cli::print_usage(argv[0]);
+      return 0;
+    }
+    if (!options.valid)
+    {
+      std::cerr << options.error << std::endl;
+      cli::print_usage(argv[0]);
+      return 1;
+    }
+    return headless::run(options);
+  }
+
   services::service_locator::instance().main_loop =
       std::make_unique<services::main_loop>();
 
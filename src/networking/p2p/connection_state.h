@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+namespace p2p
+{
+  // Lifecycle of udp_client's connection to its peer:
+  //   idle       -> connecting  first submission
+  //   connecting -> connected   peer acknowledged the connect
+  //   connecting -> backoff     refused or timed out
+  //   connected  -> backoff     peer disconnected
+  //   backoff    -> connecting  backoff elapsed with messages waiting
+  //   backoff    -> idle        backoff elapsed with nothing to send
+  enum class connection_state : uint8_t
+  {
+    idle,
+    connecting,
+    connected,
+    backoff,
+  };
+
+  inline const char* connection_state_name(connection_state state)
+  {
+    switch (state)
+    {
+    case connection_state::idle:
+      return "idle";
+    case connection_state::connecting:
+      return "connecting";
+    case connection_state::connected:
+      return "connected";
+    case connection_state::backoff:
+      return "backoff";
+    default:
+      return "unknown";
+    }
+  }
+} // namespace p2p
@@ -0,0 +1,67 @@
+#if !defined(_WIN32) && !defined(__APPLE__)
+
+#include "networking/p2p/udp_broadcast_client.h"
+#include "utils/log/log.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace p2p
+{
+
+  udp_broadcast_client::udp_broadcast_client(udp_client_configuration config)
+      : config_(std::move(config))
+  {
+    sock_ = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (sock_ < 0)
+    {
+      KP_LOG_ERROR("udp_broadcast_client",
+                   "socket failed: " << std::strerror(errno));
+      return;
+    }
+
+    int on = 1;
+    ::setsockopt(sock_, SOL_SOCKET, SO_BROADCAST, &on, sizeof(on));
+    ::setsockopt(sock_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    ::setsockopt(sock_, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+  }
+
+  udp_broadcast_client::~udp_broadcast_client()
+  {
+    if (sock_ >= 0)
+    {
+      ::close(sock_);
+      sock_ = -1;
+    }
+  }
+
+  void udp_broadcast_client::broadcast(const std::string& message)
+  {
+    if (sock_ < 0 || message.empty())
+    {
+      return;
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(config_.get_port()));
+    addr.sin_addr.s_addr = htonl(INADDR_BROADCAST);
+
+    const ssize_t sent =
+        ::sendto(sock_, message.data(), message.size(), MSG_NOSIGNAL,
+                 reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+    {
+      KP_LOG_WARN("udp_broadcast_client",
+                  "sendto failed: " << std::strerror(errno));
+    }
+  }
+
+} // namespace p2p
+
+#endif // !_WIN32 && !__APPLE__
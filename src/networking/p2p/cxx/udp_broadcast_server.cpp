@@ -0,0 +1,141 @@
+#if !defined(_WIN32) && !defined(__APPLE__)
+
+#include "networking/p2p/udp_broadcast_server.h"
+#include "utils/log/log.h"
+
+#include <arpa/inet.h>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <utility>
+
+namespace p2p
+{
+
+  namespace
+  {
+    // Datagrams received per recvmmsg call
+    constexpr unsigned int kBatchSize = 32;
+    // Calls per poll_events(); bounds the time spent on a beacon flood
+    constexpr int kMaxBatchesPerPoll = 8;
+    constexpr size_t kMaxDatagramSize = 1500;
+  } // namespace
+
+  udp_broadcast_server::udp_broadcast_server(udp_server_configuration config)
+      : config_(std::move(config))
+  {
+    sock_ = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (sock_ < 0)
+    {
+      KP_LOG_ERROR("udp_broadcast_server",
+                   "socket failed: " << std::strerror(errno));
+      return;
+    }
+
+    int on = 1;
+    ::setsockopt(sock_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    // Lets several instances on one host share the discovery port
+    ::setsockopt(sock_, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(static_cast<uint16_t>(config_.get_port()));
+    if (::bind(sock_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0)
+    {
+      KP_LOG_ERROR("udp_broadcast_server", "bind to port "
+                                               << config_.get_port()
+                                               << " failed: "
+                                               << std::strerror(errno));
+      ::close(sock_);
+      sock_ = -1;
+      return;
+    }
+  }
+
+  udp_broadcast_server::~udp_broadcast_server()
+  {
+    if (sock_ >= 0)
+    {
+      ::close(sock_);
+      sock_ = -1;
+    }
+  }
+
+  void udp_broadcast_server::poll_events()
+  {
+    if (sock_ < 0)
+    {
+      return;
+    }
+
+    std::array<std::array<char, kMaxDatagramSize>, kBatchSize> bufs;
+    std::array<sockaddr_in, kBatchSize> froms;
+    std::array<iovec, kBatchSize> iovs;
+    std::array<mmsghdr, kBatchSize> msgs;
+
+    for (int batch = 0; batch < kMaxBatchesPerPoll; ++batch)
+    {
+      for (unsigned int i = 0; i < kBatchSize; ++i)
+      {
+        iovs[i].iov_base = bufs[i].data();
+        iovs[i].iov_len = bufs[i].size();
+        msgs[i] = mmsghdr{};
+        msgs[i].msg_hdr.msg_name = &froms[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof(froms[i]);
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+      }
+
+      const int n =
+          ::recvmmsg(sock_, msgs.data(), kBatchSize, MSG_DONTWAIT, nullptr);
+      if (n < 0)
+      {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+        {
+          KP_LOG_WARN("udp_broadcast_server",
+                      "recvmmsg failed: " << std::strerror(errno));
+        }
+        return;
+      }
+
+      for (int i = 0; i < n; ++i)
+      {
+        const size_t len = msgs[i].msg_len;
+        if (len == 0 || (msgs[i].msg_hdr.msg_flags & MSG_TRUNC))
+        {
+          continue;
+        }
+
+        char ipstr[INET_ADDRSTRLEN] = {0};
+        const char* ip =
+            ::inet_ntop(AF_INET, &froms[i].sin_addr, ipstr, sizeof(ipstr));
+        if (!ip)
+        {
+          KP_LOG_WARN("udp_broadcast_server",
+                      "Failed to get sender IP address");
+          continue;
+        }
+
+        message msg;
+        msg.set_from(peer{std::string(ip)});
+        msg.set_to(peer::self());
+        msg.set_payload(std::string(bufs[i].data(), len));
+        on_message.emit(msg);
+      }
+
+      if (static_cast<unsigned int>(n) < kBatchSize)
+      {
+        return; // drained
+      }
+    }
+  }
+
+} // namespace p2p
+
+#endif // !_WIN32 && !__APPLE__
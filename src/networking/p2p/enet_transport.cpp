@@ -0,0 +1,61 @@
+#include "networking/p2p/enet_transport.h"
+
+namespace p2p
+{
+
+  enet_transport::enet_transport() = default;
+
+  enet_transport::~enet_transport()
+  {
+    disconnect();
+    // Stop the receive thread before the emitters go away
+    server_.reset();
+  }
+
+  void enet_transport::listen(const udp_server_configuration& config)
+  {
+    server_.reset();
+    server_ = std::make_unique<udp_server>(config);
+    server_->on_message.subscribe([this](const message& msg)
+                                  { deliver(msg); });
+  }
+
+  void enet_transport::connect(const udp_client_configuration& config)
+  {
+    auto client = std::make_shared<udp_client>(config);
+    client->on_state_changed.subscribe([this](const connection_state& state)
+                                       { on_state_changed.emit(state); });
+    std::atomic_store(&client_, client);
+  }
+
+  void enet_transport::disconnect()
+  {
+    std::atomic_store(&client_, std::shared_ptr<udp_client>());
+  }
+
+  void enet_transport::send(message msg, traffic_class cls)
+  {
+    const auto client = std::atomic_load(&client_);
+    if (!client)
+    {
+      count_dropped();
+      return;
+    }
+    count_sent(msg.get_payload_size());
+    if (cls == traffic_class::reliable)
+    {
+      client->send_reliable(std::move(msg));
+    }
+    else
+    {
+      client->send_unreliable(std::move(msg));
+    }
+  }
+
+  connection_state enet_transport::state() const
+  {
+    const auto client = std::atomic_load(&client_);
+    return client ? client->state() : connection_state::idle;
+  }
+
+} // namespace p2p
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "./transport.h"
+#include "./udp_client.h"
+#include "./udp_server.h"
+
+#include <memory>
+
+namespace p2p
+{
+  // transport over ENet: udp_server listens, udp_client sends. Reliable
+  // traffic gets ENet's ordered, retransmitted channel.
+  class enet_transport : public transport
+  {
+  public:
+    enet_transport();
+    ~enet_transport() override;
+
+    const char* name() const override { return "enet"; }
+
+    void listen(const udp_server_configuration& config) override;
+    void connect(const udp_client_configuration& config) override;
+    void disconnect() override;
+
+    void send(message msg, traffic_class cls) override;
+
+    connection_state state() const override;
+
+  private:
+    std::unique_ptr<udp_server> server_;
+    // Read by senders on any thread; swap with std::atomic_store
+    std::shared_ptr<udp_client> client_;
+  };
+} // namespace p2p
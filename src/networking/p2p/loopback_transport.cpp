@@ -0,0 +1,156 @@
+#include "networking/p2p/loopback_transport.h"
+
+#include "utils/latency/latency.h"
+#include "utils/log/log.h"
+
+namespace p2p
+{
+
+  loopback_transport::loopback_transport(std::chrono::microseconds latency)
+  {
+    set_latency(latency);
+    running_.store(true, std::memory_order_relaxed);
+    delivery_thread_ = std::thread(&loopback_transport::delivery_loop, this);
+  }
+
+  loopback_transport::~loopback_transport()
+  {
+    running_.store(false, std::memory_order_relaxed);
+    {
+      std::lock_guard<std::mutex> lock(wake_m_);
+    }
+    wake_cv_.notify_one();
+    if (delivery_thread_.joinable())
+    {
+      delivery_thread_.join();
+    }
+  }
+
+  void loopback_transport::listen(const udp_server_configuration& config)
+  {
+    listening_.store(true, std::memory_order_relaxed);
+    KP_LOG_INFO("loopback_transport",
+                "Listening (port " << config.get_port() << " unused)");
+  }
+
+  void loopback_transport::connect(const udp_client_configuration& config)
+  {
+    std::atomic_store(&peer_, std::make_shared<peer>(config.get_peer()));
+    on_state_changed.emit(connection_state::connected);
+  }
+
+  void loopback_transport::disconnect()
+  {
+    if (std::atomic_exchange(&peer_, std::shared_ptr<peer>()))
+    {
+      on_state_changed.emit(connection_state::idle);
+    }
+  }
+
+  void loopback_transport::send(message msg, traffic_class cls)
+  {
+    (void)cls; // the link is lossless
+    const auto to = std::atomic_load(&peer_);
+    if (!to)
+    {
+      count_dropped();
+      return;
+    }
+    msg.set_from(*to);
+    msg.set_to(peer::self());
+    const int64_t latency = latency_ns_.load(std::memory_order_relaxed);
+    const uint64_t due_ns =
+        utils::latency::now_ns() + static_cast<uint64_t>(latency);
+    const size_t size = msg.get_payload_size();
+    if (!queue_.try_push(in_flight{std::move(msg), due_ns}))
+    {
+      count_dropped();
+      KP_LOG_WARN("loopback_transport", "Queue full, dropping message");
+      return;
+    }
+    count_sent(size);
+    wake();
+  }
+
+  connection_state loopback_transport::state() const
+  {
+    return std::atomic_load(&peer_) ? connection_state::connected
+                                    : connection_state::idle;
+  }
+
+  void loopback_transport::set_latency(std::chrono::microseconds latency)
+  {
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        latency > std::chrono::microseconds(0) ? latency
+                                               : std::chrono::microseconds(0));
+    latency_ns_.store(ns.count(), std::memory_order_relaxed);
+  }
+
+  void loopback_transport::wake()
+  {
+    // Pairs with the fence in park(): either the delivery thread sees the
+    // message when it re-checks, or we see it parked and notify.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (parked_.load(std::memory_order_relaxed))
+    {
+      {
+        std::lock_guard<std::mutex> lock(wake_m_);
+      }
+      wake_cv_.notify_one();
+    }
+  }
+
+  void loopback_transport::delivery_loop()
+  {
+    in_flight next;
+    bool holding = false;
+    while (running_.load(std::memory_order_relaxed))
+    {
+      if (!holding)
+      {
+        holding = queue_.try_pop(next);
+      }
+      // FIFO: a lowered latency waits behind messages already in flight
+      while (holding && next.due_ns <= utils::latency::now_ns())
+      {
+        if (listening_.load(std::memory_order_relaxed))
+        {
+          next.msg.set_timestamp_ns(utils::latency::now_ns());
+          deliver(next.msg);
+        }
+        holding = queue_.try_pop(next);
+      }
+      park(holding ? next.due_ns : 0);
+    }
+  }
+
+  void loopback_transport::park(uint64_t due_ns)
+  {
+    std::unique_lock<std::mutex> lock(wake_m_);
+    parked_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (due_ns != 0)
+    {
+      // Nothing sent later can be due earlier; no need to watch the queue
+      const uint64_t now = utils::latency::now_ns();
+      if (due_ns > now)
+      {
+        const auto stopping = [this]
+        { return !running_.load(std::memory_order_relaxed); };
+        wake_cv_.wait_for(lock, std::chrono::nanoseconds(due_ns - now),
+                          stopping);
+      }
+    }
+    else
+    {
+      wake_cv_.wait(lock,
+                    [this]
+                    {
+                      return !running_.load(std::memory_order_relaxed) ||
+                             !queue_.empty();
+                    });
+    }
+    parked_.store(false, std::memory_order_relaxed);
+  }
+
+} // namespace p2p
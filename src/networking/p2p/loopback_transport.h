@@ -0,0 +1,76 @@
+#pragma once
+
+#include "./transport.h"
+#include "utils/mpsc_queue/mpsc_queue.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace p2p
+{
+  // In-process transport with no sockets: everything sent comes back on
+  // on_message after a fixed latency, as if the connected peer had sent
+  // it. With one communication_service shared by SenderFlow and
+  // ReceiverFlow this runs the whole input pipeline, capture to emitter,
+  // inside one process, so it can be profiled without a network.
+  //
+  // send() pushes onto a lock-free queue and wakes the delivery thread
+  // only if it is parked. The delivery thread holds each message until its
+  // due time and emits it; the link never loses or reorders anything.
+  class loopback_transport : public transport
+  {
+  public:
+    static constexpr size_t kQueueCapacity = 1024;
+
+    explicit loopback_transport(std::chrono::microseconds latency =
+                                    std::chrono::microseconds(0));
+    ~loopback_transport() override;
+
+    const char* name() const override { return "loopback"; }
+
+    // Messages are delivered only while listening.
+    void listen(const udp_server_configuration& config) override;
+    // Delivered messages come from the connected peer.
+    void connect(const udp_client_configuration& config) override;
+    void disconnect() override;
+
+    void send(message msg, traffic_class cls) override;
+
+    connection_state state() const override;
+
+    // One-way delay applied to messages sent from now on.
+    void set_latency(std::chrono::microseconds latency);
+
+  private:
+    using clock = std::chrono::steady_clock;
+
+    struct in_flight
+    {
+      message msg;
+      uint64_t due_ns = 0; // utils::latency::now_ns() time
+    };
+
+    utils::mpsc_queue<in_flight, kQueueCapacity> queue_;
+    std::atomic<int64_t> latency_ns_{0};
+    std::atomic<bool> listening_{false};
+    // Read by senders on any thread; swap with std::atomic_store
+    std::shared_ptr<peer> peer_;
+
+    std::thread delivery_thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> parked_{false};
+    std::mutex wake_m_;
+    std::condition_variable wake_cv_;
+
+    void wake();
+    void delivery_loop();
+    // Sleep until 'due_ns', or until woken when 'due_ns' is 0.
+    void park(uint64_t due_ns);
+  };
+} // namespace p2p
@@ -1,12 +1,12 @@
 #ifdef __APPLE__
 
 #include "networking/p2p/udp_broadcast_server.h"
+#include "utils/log/log.h"
 
 #include <arpa/inet.h>
 #include <cerrno>
 #include <cstring>
 #include <fcntl.h>
-#include <iostream>
 #include <netinet/in.h>
 #include <string>
 #include <sys/socket.h>
@@ -87,7 +87,7 @@ namespace p2p
 
       if (from_ip.empty())
       {
-        std::cerr << "Failed to get sender IP address" << std::endl;
+        KP_LOG_WARN("udp_broadcast_server", "Failed to get sender IP address");
         continue;
       }
 
@@ -1,14 +1,24 @@
 #include "networking/p2p/message.h"
 
+#include <utility>
+
 namespace p2p
 {
 
   message::message() = default;
   message::~message() = default;
 
-  void message::set_payload(const std::string& payload)
+  void message::set_payload(std::string payload)
+  {
+    payload_ = std::move(payload);
+    view_data_ = nullptr;
+    view_size_ = 0;
+  }
+  void message::set_payload_view(const uint8_t* data, size_t size)
   {
-    payload_ = payload;
+    payload_.clear();
+    view_data_ = data;
+    view_size_ = data ? size : 0;
   }
   void message::set_from(const peer& from)
   {
@@ -18,11 +28,33 @@ namespace p2p
   {
     to_ = to;
   }
+  void message::set_timestamp_ns(uint64_t timestamp_ns)
+  {
+    timestamp_ns_ = timestamp_ns;
+  }
+  void message::set_coalesce_key(uint32_t key)
+  {
+    coalesce_key_ = key;
+  }
 
   std::string message::get_payload() const
   {
+    if (view_data_)
+    {
+      return std::string(reinterpret_cast<const char*>(view_data_),
+                         view_size_);
+    }
     return payload_;
   }
+  const uint8_t* message::get_payload_data() const
+  {
+    return view_data_ ? view_data_
+                      : reinterpret_cast<const uint8_t*>(payload_.data());
+  }
+  size_t message::get_payload_size() const
+  {
+    return view_data_ ? view_size_ : payload_.size();
+  }
   peer message::get_from() const
   {
     return from_;
@@ -31,5 +63,13 @@ namespace p2p
   {
     return to_;
   }
+  uint64_t message::get_timestamp_ns() const
+  {
+    return timestamp_ns_;
+  }
+  uint32_t message::get_coalesce_key() const
+  {
+    return coalesce_key_;
+  }
 
 } // namespace p2p
@@ -2,27 +2,57 @@
 
 #include "networking/p2p/peer.h"
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 namespace p2p
 {
+  // A datagram and its addressing. The payload is either owned, for
+  // messages being sent, or borrowed from a receive buffer: servers point
+  // received messages at the packet bytes and release the packet once
+  // on_message has returned, so nothing is copied on the way to the
+  // decoders. Copies of a borrowing message borrow too; keep a received
+  // message past the callback only through get_payload().
   class message
   {
   public:
     message();
     ~message();
 
-    void set_payload(const std::string& payload);
+    void set_payload(std::string payload);
+    // Borrow 'size' bytes at 'data'; they must outlive this message and
+    // every copy of it.
+    void set_payload_view(const uint8_t* data, size_t size);
     void set_from(const peer& from);
     void set_to(const peer& to);
+    // Latency reference in utils::latency::now_ns() time: capture time of
+    // the oldest input in the payload when sending, receipt time when
+    // received. 0 when unknown. Local to this process; never on the wire.
+    void set_timestamp_ns(uint64_t timestamp_ns);
+    // Unreliable messages with the same nonzero key supersede each other
+    // while they wait for a connection; only the newest is sent. 0 never
+    // coalesces. Local to this process; never on the wire.
+    void set_coalesce_key(uint32_t key);
 
+    // Copy of the payload bytes
     std::string get_payload() const;
+    // The payload in place, owned or borrowed
+    const uint8_t* get_payload_data() const;
+    size_t get_payload_size() const;
     peer get_from() const;
     peer get_to() const;
+    uint64_t get_timestamp_ns() const;
+    uint32_t get_coalesce_key() const;
 
   private:
     std::string payload_;
+    // Set by set_payload_view(); payload_ is empty then
+    const uint8_t* view_data_{nullptr};
+    size_t view_size_{0};
     peer from_;
     peer to_;
+    uint64_t timestamp_ns_{0};
+    uint32_t coalesce_key_{0};
   };
 } // namespace p2p
@@ -0,0 +1,405 @@
+#include "networking/p2p/raw_udp_client.h"
+
+#include "utils/latency/latency.h"
+#include "utils/log/log.h"
+
+#include <algorithm>
+#include <random>
+
+namespace p2p
+{
+
+  namespace
+  {
+    uint32_t make_session_id()
+    {
+      std::random_device rd;
+      uint32_t id = 0;
+      while (id == 0)
+      {
+        id = rd();
+      }
+      return id;
+    }
+
+    // Serial-number distance b - a, wrapping
+    int32_t seq_distance(uint32_t a, uint32_t b)
+    {
+      return static_cast<int32_t>(b - a);
+    }
+  } // namespace
+
+  raw_udp_client::raw_udp_client(udp_client_configuration config)
+      : config_(std::move(config)), session_id_(make_session_id())
+  {
+    // Initialize ENet (idempotent); only its socket layer is used
+    enet_initialize();
+
+    const std::string ip = config_.get_peer().get_ip_address();
+    const int port = config_.get_port();
+    address_.port = static_cast<enet_uint16>(port);
+    address_valid_ = !ip.empty() && port > 0 &&
+                     enet_address_set_host(&address_, ip.c_str()) == 0;
+    if (!address_valid_)
+    {
+      KP_LOG_ERROR("raw_udp_client", "Invalid peer " << ip << ':' << port);
+      return;
+    }
+
+    socket_ = enet_socket_create(ENET_SOCKET_TYPE_DATAGRAM);
+    if (socket_ == ENET_SOCKET_NULL)
+    {
+      KP_LOG_ERROR("raw_udp_client", "Failed to create socket");
+      return;
+    }
+    ENetAddress any{};
+    any.host = ENET_HOST_ANY;
+    any.port = 0;
+    if (enet_socket_bind(socket_, &any) < 0)
+    {
+      KP_LOG_ERROR("raw_udp_client", "Failed to bind socket");
+      enet_socket_destroy(socket_);
+      socket_ = ENET_SOCKET_NULL;
+      return;
+    }
+    enet_socket_set_option(socket_, ENET_SOCKOPT_NONBLOCK, 1);
+
+    // Our own port on loopback, for wake_ack_thread()
+    if (enet_socket_get_address(socket_, &wake_address_) < 0 ||
+        enet_address_set_host(&wake_address_, "127.0.0.1") < 0)
+    {
+      KP_LOG_WARN("raw_udp_client", "No wakeup address; retransmits may "
+                                    "wait up to "
+                                        << kIdleWaitMs << " ms");
+      wake_address_.port = 0;
+    }
+
+    running_.store(true, std::memory_order_relaxed);
+    ack_thread_ = std::thread(&raw_udp_client::ack_loop, this);
+    KP_LOG_INFO("raw_udp_client", "Session " << session_id_ << " to " << ip
+                                             << ':' << port);
+  }
+
+  raw_udp_client::~raw_udp_client()
+  {
+    running_.store(false, std::memory_order_relaxed);
+    if (ack_thread_.joinable())
+    {
+      ack_thread_.join();
+    }
+    if (socket_ != ENET_SOCKET_NULL)
+    {
+      enet_socket_destroy(socket_);
+      socket_ = ENET_SOCKET_NULL;
+    }
+    // Do not deinitialize ENet globally here.
+  }
+
+  void raw_udp_client::send_unreliable(message msg)
+  {
+    const uint8_t* payload = msg.get_payload_data();
+    const size_t payload_size = msg.get_payload_size();
+    if (socket_ == ENET_SOCKET_NULL || payload_size == 0 ||
+        payload_size > raw_udp_header::kMaxPayloadSize)
+    {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      KP_LOG_WARN("raw_udp_client", "Dropping unreliable message of "
+                                        << payload_size << " bytes");
+      return;
+    }
+
+    raw_udp_header h;
+    h.kind = raw_udp_kind::unreliable;
+    h.session_id = session_id_;
+    h.seq = unreliable_seq_.fetch_add(1, std::memory_order_relaxed) + 1;
+    uint8_t header[raw_udp_header::kDataSize];
+    h.encode(header, sizeof(header));
+    if (send_datagram(header, sizeof(header), payload, payload_size))
+    {
+      utils::latency::record_since(utils::latency::stage::capture_to_send,
+                                   msg.get_timestamp_ns());
+    }
+  }
+
+  void raw_udp_client::send_reliable(message msg)
+  {
+    const size_t payload_size = msg.get_payload_size();
+    if (socket_ == ENET_SOCKET_NULL || payload_size == 0 ||
+        payload_size > raw_udp_header::kMaxPayloadSize)
+    {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      KP_LOG_WARN("raw_udp_client", "Dropping reliable message of "
+                                        << payload_size << " bytes");
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(m_);
+      // Keep order: nothing overtakes what already waits for the window
+      if (!backlog_.empty() || window_full())
+      {
+        if (backlog_.size() >= kBacklogCapacity)
+        {
+          dropped_.fetch_add(1, std::memory_order_relaxed);
+          KP_LOG_WARN("raw_udp_client", "Reliable window full and "
+                                            << kBacklogCapacity
+                                            << " messages waiting, dropping");
+          return;
+        }
+        backlog_.push_back(std::move(msg));
+        return;
+      }
+      // The ack thread may be idle in a wait that ends after this seq's
+      // first retransmit is due
+      const auto due = send_in_window(msg.get_payload_data(), payload_size);
+      if (due < ack_wait_until_)
+      {
+        ack_wait_until_ = due;
+        wake_ack_thread();
+      }
+    }
+    utils::latency::record_since(utils::latency::stage::capture_to_send,
+                                 msg.get_timestamp_ns());
+  }
+
+  raw_udp_client::stats raw_udp_client::get_stats() const
+  {
+    stats s;
+    s.datagrams_sent = datagrams_sent_.load(std::memory_order_relaxed);
+    s.bytes_sent = bytes_sent_.load(std::memory_order_relaxed);
+    s.retransmits = retransmits_.load(std::memory_order_relaxed);
+    s.acks_received = acks_received_.load(std::memory_order_relaxed);
+    s.dropped = dropped_.load(std::memory_order_relaxed);
+    return s;
+  }
+
+  bool raw_udp_client::window_full() const
+  {
+    // The receiver only tracks kAckWindow seqs past its cumulative ack,
+    // so never run further ahead of the oldest unacknowledged one.
+    const uint32_t next = reliable_seq_ + 1;
+    for (const auto& s : window_)
+    {
+      if (s.used && seq_distance(s.seq, next) >=
+                        static_cast<int32_t>(raw_udp_header::kAckWindow))
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  raw_udp_client::clock::time_point
+  raw_udp_client::send_in_window(const uint8_t* payload, size_t payload_size)
+  {
+    const uint32_t next = ++reliable_seq_;
+    slot& s = window_[next % raw_udp_header::kAckWindow];
+    raw_udp_header h;
+    h.kind = raw_udp_kind::reliable;
+    h.session_id = session_id_;
+    h.seq = next;
+    const size_t header_size = h.encode(s.datagram.data(), s.datagram.size());
+    std::copy(payload, payload + payload_size,
+              s.datagram.begin() + header_size);
+    s.used = true;
+    s.seq = next;
+    s.retries = 0;
+    s.size = header_size + payload_size;
+    s.sent_at = clock::now();
+    s.due = s.sent_at + rto_;
+    send_datagram(s.datagram.data(), s.size, nullptr, 0);
+    return s.due;
+  }
+
+  void raw_udp_client::wake_ack_thread()
+  {
+    if (wake_address_.port == 0)
+    {
+      return;
+    }
+    // Any datagram ends enet_socket_wait; ack_loop() ignores this one as it
+    // does not come from the peer
+    uint8_t byte = 0;
+    ENetBuffer buffer;
+    buffer.data = &byte;
+    buffer.dataLength = sizeof(byte);
+    enet_socket_send(socket_, &wake_address_, &buffer, 1);
+  }
+
+  bool raw_udp_client::send_backlog()
+  {
+    bool sent = false;
+    while (!backlog_.empty() && !window_full())
+    {
+      const message& msg = backlog_.front();
+      send_in_window(msg.get_payload_data(), msg.get_payload_size());
+      utils::latency::record_since(utils::latency::stage::capture_to_send,
+                                   msg.get_timestamp_ns());
+      backlog_.pop_front();
+      sent = true;
+    }
+    return sent;
+  }
+
+  bool raw_udp_client::send_datagram(const uint8_t* header,
+                                     size_t header_size,
+                                     const uint8_t* payload,
+                                     size_t payload_size)
+  {
+    ENetBuffer buffers[2];
+    buffers[0].data = const_cast<uint8_t*>(header);
+    buffers[0].dataLength = header_size;
+    size_t count = 1;
+    if (payload_size > 0)
+    {
+      buffers[1].data = const_cast<uint8_t*>(payload);
+      buffers[1].dataLength = payload_size;
+      count = 2;
+    }
+    const int sent = enet_socket_send(socket_, &address_, buffers, count);
+    if (sent <= 0)
+    {
+      // 0: socket buffer full; the datagram is lost like any other
+      KP_LOG_WARN("raw_udp_client", "Send failed");
+      return false;
+    }
+    datagrams_sent_.fetch_add(1, std::memory_order_relaxed);
+    bytes_sent_.fetch_add(static_cast<uint64_t>(sent),
+                          std::memory_order_relaxed);
+    return true;
+  }
+
+  void raw_udp_client::ack_loop()
+  {
+    std::array<uint8_t, raw_udp_header::kMaxDatagramSize> buf;
+    auto next_due = clock::time_point::max();
+    while (running_.load(std::memory_order_relaxed))
+    {
+      enet_uint32 wait_ms = kIdleWaitMs;
+      if (next_due != clock::time_point::max())
+      {
+        using std::chrono::milliseconds;
+        const auto left =
+            std::chrono::duration_cast<milliseconds>(next_due - clock::now());
+        const int64_t ms = std::min<int64_t>(left.count(), kIdleWaitMs);
+        wait_ms = static_cast<enet_uint32>(std::max<int64_t>(0, ms));
+      }
+      enet_uint32 condition = ENET_SOCKET_WAIT_RECEIVE;
+      enet_socket_wait(socket_, &condition, wait_ms);
+
+      for (;;)
+      {
+        ENetAddress from{};
+        ENetBuffer buffer;
+        buffer.data = buf.data();
+        buffer.dataLength = buf.size();
+        const int n = enet_socket_receive(socket_, &from, &buffer, 1);
+        if (n <= 0)
+        {
+          break; // drained, or an ICMP error we have nothing to do with
+        }
+        raw_udp_header h;
+        if (from.host != address_.host || from.port != address_.port ||
+            !raw_udp_header::decode(buf.data(), static_cast<size_t>(n), h) ||
+            h.kind != raw_udp_kind::ack || h.session_id != session_id_)
+        {
+          continue;
+        }
+        acks_received_.fetch_add(1, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(m_);
+        on_ack(h, clock::now());
+      }
+
+      std::lock_guard<std::mutex> lock(m_);
+      const auto now = clock::now();
+      next_due = retransmit_due(now);
+      // Acks and given-up seqs free slots for messages waiting on them
+      if (send_backlog())
+      {
+        next_due = std::min(next_due, now + rto_);
+      }
+      ack_wait_until_ =
+          std::min(next_due, now + std::chrono::milliseconds(kIdleWaitMs));
+    }
+  }
+
+  void raw_udp_client::on_ack(const raw_udp_header& ack, clock::time_point now)
+  {
+    for (auto& s : window_)
+    {
+      if (!s.used)
+      {
+        continue;
+      }
+      const int32_t d = seq_distance(ack.seq, s.seq);
+      const bool acked =
+          d <= 0 || (d >= 2 && d - 2 < static_cast<int32_t>(
+                                           raw_udp_header::kAckWindow) &&
+                     (ack.ack_mask >> (d - 2)) & 1u);
+      if (!acked)
+      {
+        continue;
+      }
+      if (s.retries == 0)
+      {
+        sample_rtt(now - s.sent_at); // Karn: only unambiguous samples
+      }
+      s.used = false;
+    }
+  }
+
+  void raw_udp_client::sample_rtt(clock::duration rtt)
+  {
+    using std::chrono::microseconds;
+    const auto r = std::chrono::duration_cast<microseconds>(rtt);
+    if (!rtt_known_)
+    {
+      srtt_ = r;
+      rttvar_ = r / 2;
+      rtt_known_ = true;
+    }
+    else
+    {
+      const auto err = r > srtt_ ? r - srtt_ : srtt_ - r;
+      rttvar_ = (rttvar_ * 3 + err) / 4;
+      srtt_ = (srtt_ * 7 + r) / 8;
+    }
+    rto_ = std::min<microseconds>(
+        std::max<microseconds>(srtt_ + rttvar_ * 4, kMinRto), kMaxRto);
+  }
+
+  raw_udp_client::clock::time_point
+  raw_udp_client::retransmit_due(clock::time_point now)
+  {
+    auto next_due = clock::time_point::max();
+    for (auto& s : window_)
+    {
+      if (!s.used)
+      {
+        continue;
+      }
+      if (s.due <= now)
+      {
+        if (s.retries >= kMaxRetries)
+        {
+          // The receiver slides past it once later seqs arrive
+          KP_LOG_WARN("raw_udp_client", "Giving up on reliable seq "
+                                            << s.seq << " after "
+                                            << s.retries << " retries");
+          s.used = false;
+          dropped_.fetch_add(1, std::memory_order_relaxed);
+          continue;
+        }
+        ++s.retries;
+        retransmits_.fetch_add(1, std::memory_order_relaxed);
+        send_datagram(s.datagram.data(), s.size, nullptr, 0);
+        const auto backoff = std::min<clock::duration>(
+            rto_ * (1 << std::min(s.retries, 6)), kMaxRto);
+        s.due = now + backoff;
+      }
+      next_due = std::min(next_due, s.due);
+    }
+    return next_due;
+  }
+
+} // namespace p2p
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "./message.h"
+#include "./raw_udp_protocol.h"
+#include "./udp_client_configuration.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <enet/enet.h>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace p2p
+{
+  // Outbound half of the raw UDP input transport (see raw_udp_protocol.h),
+  // a lighter alternative to udp_client for input traffic: no handshake,
+  // no command queues and no per-packet allocation. send_*() encodes the
+  // header on the stack and hands header and payload straight to sendto on
+  // the calling thread.
+  //
+  // Reliable messages are also copied into a fixed window of kAckWindow
+  // slots until acknowledged. A background thread waits on the socket for
+  // acks and retransmits on an RFC 6298 style timeout that doubles per
+  // retry; a send whose retransmit falls due before the thread's current
+  // wait ends wakes it with a datagram to its own socket. While the window
+  // is full, new reliable messages wait in order in a bounded backlog and
+  // go out as acks free slots.
+  class raw_udp_client
+  {
+  public:
+    struct stats
+    {
+      uint64_t datagrams_sent = 0; // including retransmits
+      uint64_t bytes_sent = 0;     // UDP payload bytes, headers included
+      uint64_t retransmits = 0;
+      uint64_t acks_received = 0;
+      uint64_t dropped = 0; // backlog full, too large or retries exhausted
+    };
+
+    raw_udp_client(udp_client_configuration config);
+    ~raw_udp_client();
+
+    // The backlog drains on acks; kept for parity with udp_client.
+    void flush_pending_messages() {}
+
+    // Any thread.
+    void send_reliable(message message);
+    void send_unreliable(message message);
+
+    stats get_stats() const;
+
+  private:
+    using clock = std::chrono::steady_clock;
+
+    static constexpr std::chrono::milliseconds kInitialRto{50};
+    static constexpr std::chrono::milliseconds kMinRto{10};
+    static constexpr std::chrono::milliseconds kMaxRto{1000};
+    static constexpr int kMaxRetries = 10;
+    // Longest the ack thread blocks with nothing to retransmit
+    static constexpr enet_uint32 kIdleWaitMs = 100;
+    // Reliable messages held behind a full window before new ones are
+    // dropped
+    static constexpr size_t kBacklogCapacity = 256;
+
+    struct slot
+    {
+      bool used = false;
+      uint32_t seq = 0;
+      int retries = 0;
+      clock::time_point sent_at{};
+      clock::time_point due{};
+      size_t size = 0;
+      std::array<uint8_t, raw_udp_header::kMaxDatagramSize> datagram{};
+    };
+
+    udp_client_configuration config_;
+    ENetSocket socket_{ENET_SOCKET_NULL};
+    ENetAddress address_{};
+    ENetAddress wake_address_{}; // own socket on loopback; port 0 if unknown
+    bool address_valid_{false};
+    uint32_t session_id_{0};
+
+    std::atomic<uint32_t> unreliable_seq_{0};
+
+    // Reliable window and RTT estimate, shared with the ack thread
+    std::mutex m_;
+    uint32_t reliable_seq_{0};
+    std::array<slot, raw_udp_header::kAckWindow> window_{};
+    std::deque<message> backlog_;
+    // When the ack thread's current socket wait ends
+    clock::time_point ack_wait_until_{clock::time_point::max()};
+    bool rtt_known_{false};
+    std::chrono::microseconds srtt_{0};
+    std::chrono::microseconds rttvar_{0};
+    std::chrono::microseconds rto_{kInitialRto};
+
+    std::atomic<uint64_t> datagrams_sent_{0};
+    std::atomic<uint64_t> bytes_sent_{0};
+    std::atomic<uint64_t> retransmits_{0};
+    std::atomic<uint64_t> acks_received_{0};
+    std::atomic<uint64_t> dropped_{0};
+
+    std::thread ack_thread_;
+    std::atomic<bool> running_{false};
+
+    bool send_datagram(const uint8_t* header, size_t header_size,
+                       const uint8_t* payload, size_t payload_size);
+    // With m_ held: whether the next seq would outrun the receiver's ack
+    // window, sending 'payload' as the next seq (returns its retransmit
+    // time), and moving the backlog into the window while it has room
+    // (true if anything was sent).
+    bool window_full() const;
+    clock::time_point send_in_window(const uint8_t* payload,
+                                     size_t payload_size);
+    bool send_backlog();
+    // Interrupt the ack thread's socket wait.
+    void wake_ack_thread();
+    void ack_loop();
+    void on_ack(const raw_udp_header& ack, clock::time_point now);
+    void sample_rtt(clock::duration rtt);
+    // Retransmit what is due; returns the next due time.
+    clock::time_point retransmit_due(clock::time_point now);
+  };
+} // namespace p2p
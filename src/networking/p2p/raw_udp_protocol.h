@@ -0,0 +1,106 @@
+#pragma once
+
+#include "utils/byte_order/byte_order.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace p2p
+{
+  // Datagram header of the raw UDP input transport (raw_udp_client and
+  // raw_udp_server): one datagram per message, no handshake.
+  //
+  // Reliable and unreliable messages are numbered separately, from 1. The
+  // receiver acks every reliable datagram with its cumulative seq (every
+  // reliable seq up to it has arrived) and a selective ack mask: bit i set
+  // means seq cumulative + 2 + i has arrived too. Reliable messages are
+  // delivered once each, in arrival order.
+  //
+  // Wire format (version 1, little-endian):
+  //   u8  version
+  //   u8  kind (raw_udp_kind)
+  //   u32 session id (random per client, never 0)
+  //   u32 seq (data) or cumulative reliable seq (ack)
+  //   u32 selective ack mask (acks only)
+  //   payload (data only)
+  enum class raw_udp_kind : uint8_t
+  {
+    unreliable = 0,
+    reliable = 1,
+    ack = 2,
+  };
+
+  struct raw_udp_header
+  {
+    static constexpr uint8_t kVersion = 1;
+    static constexpr size_t kDataSize = 1 + 1 + 4 + 4;
+    static constexpr size_t kAckSize = kDataSize + 4;
+    // Stays below the path MTU of every network we run on
+    static constexpr size_t kMaxDatagramSize = 1200;
+    static constexpr size_t kMaxPayloadSize = kMaxDatagramSize - kDataSize;
+    // Reliable datagrams a sender may have unacknowledged; the ack mask
+    // covers exactly this many beyond the cumulative seq.
+    static constexpr uint32_t kAckWindow = 32;
+
+    raw_udp_kind kind = raw_udp_kind::unreliable;
+    uint32_t session_id = 0;
+    uint32_t seq = 0;
+    uint32_t ack_mask = 0;
+
+    size_t size() const
+    {
+      return kind == raw_udp_kind::ack ? kAckSize : kDataSize;
+    }
+
+    // Returns bytes written, or 0 when 'cap' is too small.
+    inline size_t encode(uint8_t* out, size_t cap) const
+    {
+      namespace bo = utils::byte_order;
+      const size_t n = size();
+      if (!out || cap < n)
+      {
+        return 0;
+      }
+      out[0] = kVersion;
+      out[1] = static_cast<uint8_t>(kind);
+      bo::put_u32(out + 2, session_id);
+      bo::put_u32(out + 6, seq);
+      if (kind == raw_udp_kind::ack)
+      {
+        bo::put_u32(out + 10, ack_mask);
+      }
+      return n;
+    }
+
+    // Returns false on a malformed or foreign datagram; otherwise the
+    // payload starts at data + out.size().
+    static inline bool decode(const uint8_t* data, size_t size,
+                              raw_udp_header& out)
+    {
+      namespace bo = utils::byte_order;
+      if (!data || size < kDataSize || data[0] != kVersion ||
+          data[1] > static_cast<uint8_t>(raw_udp_kind::ack))
+      {
+        return false;
+      }
+      raw_udp_header h;
+      h.kind = static_cast<raw_udp_kind>(data[1]);
+      h.session_id = bo::get_u32(data + 2);
+      h.seq = bo::get_u32(data + 6);
+      if (h.session_id == 0)
+      {
+        return false;
+      }
+      if (h.kind == raw_udp_kind::ack)
+      {
+        if (size != kAckSize)
+        {
+          return false;
+        }
+        h.ack_mask = bo::get_u32(data + 10);
+      }
+      out = h;
+      return true;
+    }
+  };
+} // namespace p2p
@@ -0,0 +1,252 @@
+#include "networking/p2p/raw_udp_server.h"
+
+#include "utils/latency/latency.h"
+#include "utils/log/log.h"
+
+#include <algorithm>
+#include <string>
+
+namespace p2p
+{
+
+  raw_udp_server::raw_udp_server(udp_server_configuration config)
+      : config_(std::move(config))
+  {
+    // Initialize ENet (idempotent); only its socket layer is used
+    enet_initialize();
+
+    socket_ = enet_socket_create(ENET_SOCKET_TYPE_DATAGRAM);
+    if (socket_ == ENET_SOCKET_NULL)
+    {
+      KP_LOG_ERROR("raw_udp_server", "Failed to create socket");
+      return;
+    }
+    enet_socket_set_option(socket_, ENET_SOCKOPT_REUSEADDR, 1);
+    ENetAddress address{};
+    address.host = ENET_HOST_ANY;
+    address.port = static_cast<enet_uint16>(config_.get_port());
+    if (enet_socket_bind(socket_, &address) < 0)
+    {
+      KP_LOG_ERROR("raw_udp_server",
+                   "Failed to bind port " << config_.get_port());
+      enet_socket_destroy(socket_);
+      socket_ = ENET_SOCKET_NULL;
+      return;
+    }
+    enet_socket_set_option(socket_, ENET_SOCKOPT_NONBLOCK, 1);
+
+    KP_LOG_INFO("raw_udp_server", "Listening on port " << config_.get_port());
+    running_.store(true, std::memory_order_relaxed);
+    receive_thread_ = std::thread(&raw_udp_server::receive_loop, this);
+  }
+
+  raw_udp_server::~raw_udp_server()
+  {
+    running_.store(false, std::memory_order_relaxed);
+    if (receive_thread_.joinable())
+    {
+      receive_thread_.join();
+    }
+    if (socket_ != ENET_SOCKET_NULL)
+    {
+      enet_socket_destroy(socket_);
+      socket_ = ENET_SOCKET_NULL;
+    }
+  }
+
+  raw_udp_server::stats raw_udp_server::get_stats() const
+  {
+    stats s;
+    s.datagrams_received = datagrams_received_.load(std::memory_order_relaxed);
+    s.bytes_received = bytes_received_.load(std::memory_order_relaxed);
+    s.acks_sent = acks_sent_.load(std::memory_order_relaxed);
+    s.duplicates = duplicates_.load(std::memory_order_relaxed);
+    return s;
+  }
+
+  void raw_udp_server::receive_loop()
+  {
+    while (running_.load(std::memory_order_relaxed))
+    {
+      enet_uint32 condition = ENET_SOCKET_WAIT_RECEIVE;
+      if (enet_socket_wait(socket_, &condition, kWaitTimeoutMs) < 0 ||
+          !(condition & ENET_SOCKET_WAIT_RECEIVE))
+      {
+        continue;
+      }
+      for (;;)
+      {
+        ENetAddress from{};
+        ENetBuffer buffer;
+        buffer.data = buffer_.data();
+        buffer.dataLength = buffer_.size();
+        const int n = enet_socket_receive(socket_, &from, &buffer, 1);
+        if (n == 0)
+        {
+          break; // drained
+        }
+        if (n < 0)
+        {
+          // Truncated datagram or a transient socket error
+          KP_LOG_WARN("raw_udp_server", "Receive failed");
+          break;
+        }
+        handle_datagram(from, static_cast<size_t>(n));
+      }
+    }
+  }
+
+  void raw_udp_server::handle_datagram(const ENetAddress& from, size_t size)
+  {
+    const uint64_t received_ns = utils::latency::now_ns();
+    datagrams_received_.fetch_add(1, std::memory_order_relaxed);
+    bytes_received_.fetch_add(size, std::memory_order_relaxed);
+
+    raw_udp_header h;
+    if (!raw_udp_header::decode(buffer_.data(), size, h) ||
+        h.kind == raw_udp_kind::ack)
+    {
+      KP_LOG_DEBUG("raw_udp_server", "Ignoring foreign datagram");
+      return;
+    }
+
+    session& s = find_session(from, h.session_id, clock::now());
+    if (h.kind == raw_udp_kind::reliable)
+    {
+      const bool fresh = accept_reliable(s, h.seq);
+      // Ack duplicates too: the earlier ack may be the one that was lost
+      send_ack(s);
+      if (!fresh)
+      {
+        duplicates_.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+    }
+
+    char ip[64] = {0};
+    if (enet_address_get_host_ip(&from, ip, sizeof(ip)) != 0)
+    {
+      KP_LOG_WARN("raw_udp_server", "Failed to get from IP address");
+      return;
+    }
+    const size_t header_size = h.size();
+    message msg;
+    msg.set_timestamp_ns(received_ns);
+    msg.set_from(peer{std::string(ip)});
+    msg.set_to(peer::self());
+    // Borrowed: the buffer is not reused until emit() returns
+    msg.set_payload_view(buffer_.data() + header_size, size - header_size);
+    on_message.emit(msg);
+  }
+
+  raw_udp_server::session& raw_udp_server::find_session(
+      const ENetAddress& from, uint32_t id, clock::time_point now)
+  {
+    auto it = std::find_if(sessions_.begin(), sessions_.end(),
+                           [&](const session& s)
+                           {
+                             return s.address.host == from.host &&
+                                    s.address.port == from.port;
+                           });
+    if (it != sessions_.end() && it->id == id)
+    {
+      it->last_heard = now;
+      return *it;
+    }
+
+    if (it == sessions_.end())
+    {
+      // Forget senders that went quiet, then make room if still full
+      sessions_.erase(std::remove_if(sessions_.begin(), sessions_.end(),
+                                     [&](const session& s)
+                                     {
+                                       return now - s.last_heard >
+                                              kSessionIdleTimeout;
+                                     }),
+                      sessions_.end());
+      if (sessions_.size() >= kMaxSessions)
+      {
+        sessions_.erase(std::min_element(
+            sessions_.begin(), sessions_.end(),
+            [](const session& a, const session& b)
+            { return a.last_heard < b.last_heard; }));
+      }
+      sessions_.emplace_back();
+      it = sessions_.end() - 1;
+    }
+
+    KP_LOG_INFO("raw_udp_server", "New session " << id);
+    *it = session{};
+    it->address = from;
+    it->id = id;
+    it->last_heard = now;
+    return *it;
+  }
+
+  bool raw_udp_server::accept_reliable(session& s, uint32_t seq)
+  {
+    const int32_t ahead = static_cast<int32_t>(seq - s.cumulative);
+    if (ahead <= 0)
+    {
+      return false;
+    }
+
+    // Count cumulative + 1 as done and absorb whatever arrived after it
+    auto advance = [&s]
+    {
+      ++s.cumulative;
+      while (s.mask & 1u)
+      {
+        s.mask >>= 1;
+        ++s.cumulative;
+      }
+      s.mask >>= 1;
+    };
+
+    // The sender gave up on everything before its window; do the same
+    constexpr int32_t kWindow =
+        static_cast<int32_t>(raw_udp_header::kAckWindow);
+    if (ahead > 2 * kWindow)
+    {
+      s.cumulative = seq - static_cast<uint32_t>(kWindow + 1);
+      s.mask = 0;
+    }
+    while (static_cast<int32_t>(seq - s.cumulative) > kWindow + 1)
+    {
+      advance();
+    }
+
+    const int32_t bit = static_cast<int32_t>(seq - s.cumulative) - 2;
+    if (bit < 0)
+    {
+      advance();
+      return true;
+    }
+    if ((s.mask >> bit) & 1u)
+    {
+      return false;
+    }
+    s.mask |= 1u << bit;
+    return true;
+  }
+
+  void raw_udp_server::send_ack(const session& s)
+  {
+    raw_udp_header h;
+    h.kind = raw_udp_kind::ack;
+    h.session_id = s.id;
+    h.seq = s.cumulative;
+    h.ack_mask = s.mask;
+    uint8_t datagram[raw_udp_header::kAckSize];
+    h.encode(datagram, sizeof(datagram));
+
+    ENetBuffer buffer;
+    buffer.data = datagram;
+    buffer.dataLength = sizeof(datagram);
+    if (enet_socket_send(socket_, &s.address, &buffer, 1) > 0)
+    {
+      acks_sent_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+} // namespace p2p
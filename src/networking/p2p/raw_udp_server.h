@@ -0,0 +1,82 @@
+#pragma once
+
+#include "./message.h"
+#include "./raw_udp_protocol.h"
+#include "./udp_server_configuration.h"
+#include "utils/event_emitter/event_emitter.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <enet/enet.h>
+#include <thread>
+#include <vector>
+
+namespace p2p
+{
+  // Inbound half of the raw UDP input transport (see raw_udp_protocol.h).
+  // A receive thread blocks in enet_socket_wait, drains every datagram that
+  // is ready, acks reliable ones immediately and emits each message once.
+  // Senders are told apart by address and session id; a new session id
+  // from a known address starts that sender over.
+  class raw_udp_server
+  {
+  public:
+    struct stats
+    {
+      uint64_t datagrams_received = 0;
+      uint64_t bytes_received = 0; // UDP payload bytes, headers included
+      uint64_t acks_sent = 0;
+      uint64_t duplicates = 0; // reliable datagrams already delivered
+    };
+
+    raw_udp_server(udp_server_configuration config);
+    ~raw_udp_server();
+
+    // Emitted on the receive thread, once per message. The message borrows
+    // the receive buffer, which is reused when emit() returns.
+    utils::event_emitter<message> on_message;
+
+    stats get_stats() const;
+
+  private:
+    using clock = std::chrono::steady_clock;
+
+    // Longest the receive thread blocks; bounds shutdown latency.
+    static constexpr enet_uint32 kWaitTimeoutMs = 100;
+    static constexpr size_t kMaxSessions = 16;
+    static constexpr std::chrono::seconds kSessionIdleTimeout{30};
+
+    // Receive thread only
+    struct session
+    {
+      ENetAddress address{};
+      uint32_t id = 0;
+      uint32_t cumulative = 0; // every reliable seq up to this arrived
+      uint32_t mask = 0;       // bit i: cumulative + 2 + i arrived
+      clock::time_point last_heard{};
+    };
+
+    udp_server_configuration config_;
+    ENetSocket socket_{ENET_SOCKET_NULL};
+    std::vector<session> sessions_;
+    std::array<uint8_t, raw_udp_header::kMaxDatagramSize> buffer_{};
+
+    std::atomic<uint64_t> datagrams_received_{0};
+    std::atomic<uint64_t> bytes_received_{0};
+    std::atomic<uint64_t> acks_sent_{0};
+    std::atomic<uint64_t> duplicates_{0};
+
+    std::thread receive_thread_;
+    std::atomic<bool> running_{false};
+
+    void receive_loop();
+    void handle_datagram(const ENetAddress& from, size_t size);
+    session& find_session(const ENetAddress& from, uint32_t id,
+                          clock::time_point now);
+    // Record reliable 'seq'; returns false if it was delivered before.
+    bool accept_reliable(session& s, uint32_t seq);
+    void send_ack(const session& s);
+  };
+} // namespace p2p
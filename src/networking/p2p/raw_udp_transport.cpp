@@ -0,0 +1,62 @@
+#include "networking/p2p/raw_udp_transport.h"
+
+namespace p2p
+{
+
+  raw_udp_transport::raw_udp_transport() = default;
+
+  raw_udp_transport::~raw_udp_transport()
+  {
+    disconnect();
+    // Stop the receive thread before the emitters go away
+    server_.reset();
+  }
+
+  void raw_udp_transport::listen(const udp_server_configuration& config)
+  {
+    server_.reset();
+    server_ = std::make_unique<raw_udp_server>(config);
+    server_->on_message.subscribe([this](const message& msg)
+                                  { deliver(msg); });
+  }
+
+  void raw_udp_transport::connect(const udp_client_configuration& config)
+  {
+    std::atomic_store(&client_, std::make_shared<raw_udp_client>(config));
+    on_state_changed.emit(connection_state::connected);
+  }
+
+  void raw_udp_transport::disconnect()
+  {
+    if (std::atomic_exchange(&client_, std::shared_ptr<raw_udp_client>()))
+    {
+      on_state_changed.emit(connection_state::idle);
+    }
+  }
+
+  void raw_udp_transport::send(message msg, traffic_class cls)
+  {
+    const auto client = std::atomic_load(&client_);
+    if (!client)
+    {
+      count_dropped();
+      return;
+    }
+    count_sent(msg.get_payload_size());
+    if (cls == traffic_class::reliable)
+    {
+      client->send_reliable(std::move(msg));
+    }
+    else
+    {
+      client->send_unreliable(std::move(msg));
+    }
+  }
+
+  connection_state raw_udp_transport::state() const
+  {
+    return std::atomic_load(&client_) ? connection_state::connected
+                                      : connection_state::idle;
+  }
+
+} // namespace p2p
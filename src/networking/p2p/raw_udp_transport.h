@@ -0,0 +1,35 @@
+#pragma once
+
+#include "./raw_udp_client.h"
+#include "./raw_udp_server.h"
+#include "./transport.h"
+
+#include <memory>
+
+namespace p2p
+{
+  // transport over the raw UDP protocol (see raw_udp_protocol.h). There is
+  // no handshake, so a connected transport is connected at once; reliable
+  // traffic is retransmitted but not ordered.
+  class raw_udp_transport : public transport
+  {
+  public:
+    raw_udp_transport();
+    ~raw_udp_transport() override;
+
+    const char* name() const override { return "raw_udp"; }
+
+    void listen(const udp_server_configuration& config) override;
+    void connect(const udp_client_configuration& config) override;
+    void disconnect() override;
+
+    void send(message msg, traffic_class cls) override;
+
+    connection_state state() const override;
+
+  private:
+    std::unique_ptr<raw_udp_server> server_;
+    // Read by senders on any thread; swap with std::atomic_store
+    std::shared_ptr<raw_udp_client> client_;
+  };
+} // namespace p2p
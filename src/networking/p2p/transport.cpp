@@ -0,0 +1,85 @@
+#include "networking/p2p/transport.h"
+
+#include "networking/p2p/enet_transport.h"
+#include "networking/p2p/loopback_transport.h"
+#include "networking/p2p/raw_udp_transport.h"
+
+namespace p2p
+{
+
+  const char* transport_kind_name(transport_kind kind)
+  {
+    switch (kind)
+    {
+    case transport_kind::enet:
+      return "enet";
+    case transport_kind::raw_udp:
+      return "raw_udp";
+    case transport_kind::loopback:
+      return "loopback";
+    default:
+      return "unknown";
+    }
+  }
+
+  bool transport_kind_from_name(const std::string& name, transport_kind& out)
+  {
+    for (const auto kind : {transport_kind::enet, transport_kind::raw_udp,
+                            transport_kind::loopback})
+    {
+      if (name == transport_kind_name(kind))
+      {
+        out = kind;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  transport::stats transport::get_stats() const
+  {
+    stats s;
+    s.messages_sent = messages_sent_.load(std::memory_order_relaxed);
+    s.bytes_sent = bytes_sent_.load(std::memory_order_relaxed);
+    s.messages_received = messages_received_.load(std::memory_order_relaxed);
+    s.bytes_received = bytes_received_.load(std::memory_order_relaxed);
+    s.dropped = dropped_.load(std::memory_order_relaxed);
+    return s;
+  }
+
+  void transport::count_sent(size_t payload_size)
+  {
+    messages_sent_.fetch_add(1, std::memory_order_relaxed);
+    bytes_sent_.fetch_add(payload_size, std::memory_order_relaxed);
+  }
+
+  void transport::count_dropped()
+  {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void transport::deliver(const message& msg)
+  {
+    messages_received_.fetch_add(1, std::memory_order_relaxed);
+    bytes_received_.fetch_add(msg.get_payload_size(),
+                              std::memory_order_relaxed);
+    on_message.emit(msg);
+  }
+
+  std::unique_ptr<transport>
+  make_transport(transport_kind kind,
+                 std::chrono::microseconds loopback_latency)
+  {
+    switch (kind)
+    {
+    case transport_kind::raw_udp:
+      return std::make_unique<raw_udp_transport>();
+    case transport_kind::loopback:
+      return std::make_unique<loopback_transport>(loopback_latency);
+    case transport_kind::enet:
+    default:
+      return std::make_unique<enet_transport>();
+    }
+  }
+
+} // namespace p2p
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "./connection_state.h"
+#include "./message.h"
+#include "./udp_client_configuration.h"
+#include "./udp_server_configuration.h"
+#include "utils/event_emitter/event_emitter.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace p2p
+{
+  enum class traffic_class : uint8_t
+  {
+    // Delivered unless the link stays down (keys, buttons, control)
+    reliable,
+    // May be lost; only the newest one matters (motion, state syncs)
+    unreliable,
+  };
+
+  enum class transport_kind : uint8_t
+  {
+    enet,     // udp_client / udp_server
+    raw_udp,  // raw_udp_client / raw_udp_server
+    loopback, // in-process, no sockets
+  };
+
+  const char* transport_kind_name(transport_kind kind);
+  // Parses a transport_kind_name(); returns false for unknown names.
+  bool transport_kind_from_name(const std::string& name,
+                                transport_kind& out);
+
+  // One endpoint of a message transport: it listens for inbound messages
+  // and sends to at most one connected peer. Implementations own their
+  // threads; send() may be called from any thread and never blocks, and
+  // on_message fires on the implementation's receive thread.
+  class transport
+  {
+  public:
+    struct stats
+    {
+      uint64_t messages_sent = 0; // accepted by send()
+      uint64_t bytes_sent = 0;    // message payload bytes
+      uint64_t messages_received = 0;
+      uint64_t bytes_received = 0;
+      uint64_t dropped = 0; // refused by send(), e.g. not connected
+    };
+
+    virtual ~transport() = default;
+
+    virtual const char* name() const = 0;
+
+    // Start receiving on the configured port.
+    virtual void listen(const udp_server_configuration& config) = 0;
+    // Send to the configured peer from now on, replacing any previous one.
+    virtual void connect(const udp_client_configuration& config) = 0;
+    virtual void disconnect() = 0;
+
+    virtual void send(message msg, traffic_class cls) = 0;
+
+    virtual connection_state state() const = 0;
+
+    stats get_stats() const;
+
+    // Every received message, once. The payload may be borrowed and is
+    // only valid during the callback (see message).
+    utils::event_emitter<message> on_message;
+    // Connection state transitions, on the transport's own thread.
+    utils::event_emitter<connection_state> on_state_changed;
+
+  protected:
+    // Bookkeeping for implementations
+    void count_sent(size_t payload_size);
+    void count_dropped();
+    // Count and emit a received message.
+    void deliver(const message& msg);
+
+  private:
+    std::atomic<uint64_t> messages_sent_{0};
+    std::atomic<uint64_t> bytes_sent_{0};
+    std::atomic<uint64_t> messages_received_{0};
+    std::atomic<uint64_t> bytes_received_{0};
+    std::atomic<uint64_t> dropped_{0};
+  };
+
+  // 'loopback_latency' applies to transport_kind::loopback only.
+  std::unique_ptr<transport>
+  make_transport(transport_kind kind,
+                 std::chrono::microseconds loopback_latency =
+                     std::chrono::microseconds(0));
+} // namespace p2p
@@ -2,80 +2,16 @@
 
 #include "networking/p2p/message.h"
 #include "networking/p2p/peer.h"
+#include "utils/latency/latency.h"
+#include "utils/log/log.h"
 
+#include <algorithm>
 #include <chrono>
 #include <enet/enet.h>
-#include <iostream>
 
 namespace p2p
 {
 
-  namespace
-  {
-    // Connect to the target peer; returns connected ENetPeer* or nullptr on
-    // failure
-    ENetPeer* connect_peer(ENetHost* host, const std::string& ip, int port,
-                           int timeout_ms = 250)
-    {
-      if (!host || ip.empty() || port <= 0)
-      {
-        return nullptr;
-      }
-
-      ENetAddress address{};
-      address.port = static_cast<enet_uint16>(port);
-      if (enet_address_set_host(&address, ip.c_str()) != 0)
-      {
-        return nullptr;
-      }
-
-      ENetPeer* peer =
-          enet_host_connect(host, &address, /*channels*/ 2, /*data*/ 0);
-      if (!peer)
-      {
-        return nullptr;
-      }
-
-      ENetEvent ev;
-      int elapsed = 0;
-      while (elapsed < timeout_ms)
-      {
-        int rc = enet_host_service(host, &ev, 50);
-        elapsed += 50;
-        if (rc > 0 && ev.type == ENET_EVENT_TYPE_CONNECT)
-        {
-          return peer;
-        }
-        if (rc > 0 && ev.type == ENET_EVENT_TYPE_DISCONNECT)
-        {
-          break;
-        }
-      }
-
-      enet_peer_reset(peer);
-      return nullptr;
-    }
-
-    void disconnect_peer(ENetHost* host, ENetPeer* peer)
-    {
-      if (!host || !peer)
-      {
-        return;
-      }
-      ENetEvent ev;
-      enet_peer_disconnect(peer, 0);
-      for (int i = 0; i < 5; ++i)
-      {
-        if (enet_host_service(host, &ev, 20) > 0 &&
-            ev.type == ENET_EVENT_TYPE_DISCONNECT)
-        {
-          return;
-        }
-      }
-      enet_peer_reset(peer);
-    }
-  } // namespace
-
   udp_client::udp_client(udp_client_configuration config)
       : config_(std::move(config))
   {
@@ -86,28 +22,26 @@ namespace p2p
                              0, 0);
     if (!host_)
     {
-      std::cerr << "[udp_client] Failed to create client host" << std::endl;
+      KP_LOG_ERROR("udp_client", "Failed to create client host");
     }
+    running_.store(true, std::memory_order_relaxed);
+    io_thread_ = std::thread(&udp_client::io_loop, this);
   }
 
   udp_client::~udp_client()
   {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (peer_)
+    running_.store(false, std::memory_order_relaxed);
     {
-      enet_peer_disconnect(peer_, 0);
-      ENetEvent ev;
-      for (int i = 0; i < 3; ++i)
-      {
-        if (enet_host_service(host_, &ev, 20) > 0 &&
-            ev.type == ENET_EVENT_TYPE_DISCONNECT)
-        {
-          break;
-        }
-      }
-      enet_peer_reset(peer_);
-      peer_ = nullptr;
+      std::lock_guard<std::mutex> lock(wake_m_);
     }
+    wake_cv_.notify_one();
+    if (io_thread_.joinable())
+    {
+      io_thread_.join();
+    }
+
+    // The I/O thread is gone; the host is ours now
+    disconnect();
     if (host_)
     {
       enet_host_destroy(host_);
@@ -118,12 +52,53 @@ namespace p2p
 
   void udp_client::send_reliable(message msg)
   {
-    send_impl(std::move(msg), true);
+    submit(std::move(msg), true);
   }
 
   void udp_client::send_unreliable(message msg)
   {
-    send_impl(std::move(msg), false);
+    submit(std::move(msg), false);
+  }
+
+  void udp_client::flush_pending_messages()
+  {
+    wake();
+  }
+
+  void udp_client::submit(message msg, bool is_reliable)
+  {
+    submission s;
+    s.payload = msg.get_payload();
+    s.timestamp_ns = msg.get_timestamp_ns();
+    s.coalesce_key = msg.get_coalesce_key();
+    s.reliable = is_reliable;
+    if (s.payload.empty())
+    {
+      KP_LOG_WARN("udp_client", "Attempt to send empty payload");
+      return;
+    }
+    if (!submissions_.try_push(std::move(s)))
+    {
+      KP_LOG_WARN("udp_client", "Send queue full, dropping "
+                                    << (is_reliable ? "reliable" : "unreliable")
+                                    << " packet");
+      return;
+    }
+    wake();
+  }
+
+  void udp_client::wake()
+  {
+    // Pairs with the fence in park(): either the I/O thread sees the
+    // submission when it re-checks, or we see it parked and notify.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (parked_.load(std::memory_order_relaxed))
+    {
+      {
+        std::lock_guard<std::mutex> lock(wake_m_);
+      }
+      wake_cv_.notify_one();
+    }
   }
 
   unsigned long long udp_client::now_ms() const
@@ -133,65 +108,217 @@ namespace p2p
         .count();
   }
 
-  bool udp_client::ensure_connected()
+  void udp_client::io_loop()
   {
-    // Already connected
-    if (peer_ && peer_->state == ENET_PEER_STATE_CONNECTED)
+    while (running_.load(std::memory_order_relaxed))
     {
-      return true;
+      service_events();
+      step_connection();
+      drain_submissions();
+      park();
     }
+  }
 
-    // If we have a stale peer pointer, reset it
-    if (peer_ && peer_->state != ENET_PEER_STATE_CONNECTED)
+  size_t udp_client::drain_submissions()
+  {
+    submission s;
+    if (state() != connection_state::connected)
     {
-      enet_peer_reset(peer_);
-      peer_ = nullptr;
+      while (submissions_.try_pop(s))
+      {
+        hold(std::move(s));
+      }
+      return 0;
     }
 
-    unsigned long long now = now_ms();
-    if (last_connect_attempt_ms_ != 0 &&
-        static_cast<long long>(now - last_connect_attempt_ms_) <
-            reconnect_interval_ms_)
+    size_t sent = 0;
+    size_t bytes = 0;
+    const auto send = [&](submission& out)
     {
-      return false; // too soon to retry
+      if (send_one(out))
+      {
+        ++sent;
+        bytes += out.payload.size();
+        sent_stamps_.push_back(out.timestamp_ns);
+      }
+    };
+    // Whatever waited for the connection goes first, in order
+    for (auto& held : pending_)
+    {
+      send(held);
+    }
+    pending_.clear();
+    while (submissions_.try_pop(s))
+    {
+      send(s);
+    }
+    if (sent == 0)
+    {
+      return 0;
     }
-    last_connect_attempt_ms_ = now;
 
-    const std::string ip = config_.get_peer().get_ip_address();
-    const int port = config_.get_port();
-    if (ip.empty() || port <= 0)
+    // One flush for the whole cycle
+    enet_host_flush(host_);
+    for (const uint64_t stamp : sent_stamps_)
     {
-      std::cerr << "[udp_client] Cannot connect: invalid peer info"
-                << std::endl;
-      return false;
+      utils::latency::record_since(utils::latency::stage::capture_to_send,
+                                   stamp);
     }
-    std::cout << "[udp_client] Attempting connect to " << ip << ':' << port
-              << std::endl;
-    peer_ = connect_peer(host_, ip, port, connect_timeout_ms_);
-    if (!peer_ || peer_->state != ENET_PEER_STATE_CONNECTED)
+    sent_stamps_.clear();
+    KP_LOG_DEBUG("udp_client", "Sent " << sent << " packet(s), " << bytes
+                                   << " bytes");
+    return sent;
+  }
+
+  void udp_client::hold(submission&& s)
+  {
+    if (!s.reliable && s.coalesce_key != 0)
     {
-      std::cerr << "[udp_client] Connect attempt failed" << std::endl;
-      if (peer_ && peer_->state != ENET_PEER_STATE_CONNECTED)
+      for (auto it = pending_.begin(); it != pending_.end(); ++it)
       {
-        enet_peer_reset(peer_);
-        peer_ = nullptr;
+        if (!it->reliable && it->coalesce_key == s.coalesce_key)
+        {
+          // Superseded; the newest goes out in its own place in line
+          pending_.erase(it);
+          break;
+        }
       }
+    }
+    if (pending_.size() >= kPendingCapacity)
+    {
+      KP_LOG_WARN("udp_client", "Not connected and " << kPendingCapacity
+                                    << " packets waiting, dropping "
+                                    << (s.reliable ? "reliable" : "unreliable")
+                                    << " packet");
+      return;
+    }
+    pending_.push_back(std::move(s));
+  }
+
+  bool udp_client::send_one(submission& s)
+  {
+    const enet_uint32 flags = s.reliable
+                                  ? ENET_PACKET_FLAG_RELIABLE
+                                  : ENET_PACKET_FLAG_UNRELIABLE_FRAGMENT;
+    ENetPacket* packet =
+        enet_packet_create(s.payload.data(), s.payload.size(), flags);
+    if (!packet)
+    {
+      KP_LOG_ERROR("udp_client", "Failed to create ENet packet");
+      return false;
+    }
+
+    const enet_uint8 channel =
+        s.reliable ? kChannelReliable : kChannelUnreliable;
+    if (enet_peer_send(peer_, channel, packet) < 0)
+    {
+      enet_packet_destroy(packet);
+      // keep state as-is; no reconnects here
+      KP_LOG_ERROR("udp_client", "enet_peer_send failed");
       return false;
     }
-    std::cout << "[udp_client] Connected" << std::endl;
     return true;
   }
 
-  void udp_client::send_impl(message msg, bool is_reliable)
+  void udp_client::service_events()
   {
-    std::lock_guard<std::mutex> lock(mutex_);
-    const std::string payload = msg.get_payload();
-    if (payload.empty())
+    if (!host_)
     {
-      std::cerr << "[udp_client] Attempt to send empty payload" << std::endl;
       return;
     }
+    ENetEvent ev;
+    int budget = 16; // small budget per cycle
+    while (budget-- > 0 && enet_host_service(host_, &ev, 0) > 0)
+    {
+      if (ev.type == ENET_EVENT_TYPE_CONNECT && ev.peer == peer_)
+      {
+        on_connected();
+      }
+      else if (ev.type == ENET_EVENT_TYPE_DISCONNECT && ev.peer == peer_)
+      {
+        on_connection_lost(state() == connection_state::connecting
+                               ? "refused"
+                               : "lost");
+      }
+      else if (ev.type == ENET_EVENT_TYPE_RECEIVE)
+      {
+        // client has no external handlers
+        enet_packet_destroy(ev.packet);
+      }
+    }
+  }
+
+  void udp_client::park()
+  {
+    std::unique_lock<std::mutex> lock(wake_m_);
+    parked_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const auto ready = [this]
+    {
+      return !running_.load(std::memory_order_relaxed) ||
+             !submissions_.empty();
+    };
+    switch (state())
+    {
+    case connection_state::connecting:
+    case connection_state::connected:
+      // Keep the handshake, acks and retransmits moving
+      wake_cv_.wait_for(lock, std::chrono::milliseconds(kServiceIntervalMs),
+                        ready);
+      break;
+    case connection_state::backoff:
+    {
+      const unsigned long long now = now_ms();
+      const unsigned long long left =
+          backoff_until_ms_ > now ? backoff_until_ms_ - now : 0;
+      wake_cv_.wait_for(lock, std::chrono::milliseconds(left), ready);
+      break;
+    }
+    case connection_state::idle:
+      wake_cv_.wait(lock, ready);
+      break;
+    }
+    parked_.store(false, std::memory_order_relaxed);
+  }
 
+  void udp_client::step_connection()
+  {
+    const bool has_work = !pending_.empty() || !submissions_.empty();
+    switch (state())
+    {
+    case connection_state::idle:
+      if (has_work)
+      {
+        begin_connect();
+      }
+      break;
+    case connection_state::connecting:
+      if (now_ms() >= connect_deadline_ms_)
+      {
+        on_connection_lost("timed out");
+      }
+      break;
+    case connection_state::connected:
+      break;
+    case connection_state::backoff:
+      if (now_ms() < backoff_until_ms_)
+      {
+        break;
+      }
+      if (has_work)
+      {
+        begin_connect();
+      }
+      else
+      {
+        set_state(connection_state::idle);
+      }
+      break;
+    }
+  }
+
+  void udp_client::begin_connect()
+  {
     // Ensure host exists
     if (!host_)
     {
@@ -199,94 +326,88 @@ namespace p2p
                                0, 0);
       if (!host_)
       {
-        std::cerr << "[udp_client] Could not recreate host" << std::endl;
+        KP_LOG_ERROR("udp_client", "Could not recreate host");
+        on_connection_lost("failed");
         return;
       }
     }
 
-    // Lazy connect on first send only
-    // Poll for any disconnect events quickly (non-blocking)
-    if (host_)
-    {
-      ENetEvent ev;
-      while (enet_host_service(host_, &ev, 0) > 0)
-      {
-        if (ev.type == ENET_EVENT_TYPE_DISCONNECT)
-        {
-          std::cerr << "[udp_client] Detected disconnect" << std::endl;
-          if (peer_)
-          {
-            enet_peer_reset(peer_);
-            peer_ = nullptr;
-          }
-        }
-      }
-    }
-
-    if (!ensure_connected())
+    const std::string ip = config_.get_peer().get_ip_address();
+    const int port = config_.get_port();
+    ENetAddress address{};
+    address.port = static_cast<enet_uint16>(port);
+    if (ip.empty() || port <= 0 ||
+        enet_address_set_host(&address, ip.c_str()) != 0)
     {
-      std::cerr << "[udp_client] Cannot send: not connected (will retry)"
-                << std::endl;
+      KP_LOG_WARN("udp_client", "Cannot connect: invalid peer info");
+      on_connection_lost("failed");
       return;
     }
 
-    const enet_uint32 flags = is_reliable
-                                  ? ENET_PACKET_FLAG_RELIABLE
-                                  : ENET_PACKET_FLAG_UNRELIABLE_FRAGMENT;
-    ENetPacket* packet =
-        enet_packet_create(payload.data(), payload.size(), flags);
-    if (!packet)
+    peer_ = enet_host_connect(host_, &address, /*channels*/ 2, /*data*/ 0);
+    if (!peer_)
     {
-      std::cerr << "[udp_client] Failed to create ENet packet" << std::endl;
+      on_connection_lost("failed");
       return;
     }
+    KP_LOG_INFO("udp_client", "Attempting connect to " << ip << ':' << port);
+    connect_deadline_ms_ = now_ms() + kConnectTimeoutMs;
+    set_state(connection_state::connecting);
+  }
 
-    const enet_uint8 channel =
-        is_reliable ? kChannelReliable : kChannelUnreliable;
-    if (enet_peer_send(peer_, channel, packet) < 0)
+  void udp_client::on_connected()
+  {
+    backoff_ms_ = kBackoffInitialMs;
+    KP_LOG_INFO("udp_client", "Connected, " << pending_.size()
+                                  << " packet(s) waiting");
+    set_state(connection_state::connected);
+  }
+
+  void udp_client::on_connection_lost(const char* reason)
+  {
+    if (peer_)
     {
-      enet_packet_destroy(packet);
-      // keep state as-is; no reconnects here
-      std::cerr << "[udp_client] enet_peer_send failed" << std::endl;
-      return;
+      enet_peer_reset(peer_);
+      peer_ = nullptr;
     }
-    enet_host_flush(host_);
-    std::cout << "[udp_client] Sent " << payload.size()
-              << (is_reliable ? " reliable" : " unreliable") << " bytes"
-              << std::endl;
+    KP_LOG_WARN("udp_client", "Connection " << reason << ", retrying in "
+                                  << backoff_ms_ << " ms");
+    backoff_until_ms_ = now_ms() + backoff_ms_;
+    backoff_ms_ = std::min(backoff_ms_ * 2, kBackoffMaxMs);
+    set_state(connection_state::backoff);
   }
 
-  void udp_client::flush_pending_messages()
+  void udp_client::set_state(connection_state next)
   {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (!host_)
+    const connection_state prev = state();
+    if (prev == next)
     {
       return;
     }
-
-    flush_service_events();
-    enet_host_flush(host_);
+    state_.store(next, std::memory_order_relaxed);
+    KP_LOG_INFO("udp_client", "State " << connection_state_name(prev) << " -> "
+                                  << connection_state_name(next));
+    on_state_changed.emit(next);
   }
 
-  void udp_client::flush_service_events()
+  void udp_client::disconnect()
   {
-    // Assumes mutex_ is already held and host_ is non-null
+    if (!host_ || !peer_)
+    {
+      return;
+    }
+    enet_peer_disconnect(peer_, 0);
     ENetEvent ev;
-    int budget = 16; // small budget per tick
-    while (budget-- > 0 && enet_host_service(host_, &ev, 0) > 0)
+    for (int i = 0; i < 3; ++i)
     {
-      if (ev.type == ENET_EVENT_TYPE_DISCONNECT)
+      if (enet_host_service(host_, &ev, 20) > 0 &&
+          ev.type == ENET_EVENT_TYPE_DISCONNECT)
       {
-        std::cerr << "[udp_client] Detected disconnect during flush"
-                  << std::endl;
-        if (peer_)
-        {
-          enet_peer_reset(peer_);
-          peer_ = nullptr;
-        }
+        break;
       }
-      // ignore CONNECT/RECEIVE here; client has no external handlers
     }
+    enet_peer_reset(peer_);
+    peer_ = nullptr;
   }
 
 } // namespace p2p
@@ -1,48 +1,127 @@
 #pragma once
 
+#include "./connection_state.h"
 #include "./message.h"
 #include "./udp_client_configuration.h"
+#include "utils/event_emitter/event_emitter.h"
+#include "utils/mpsc_queue/mpsc_queue.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <enet/enet.h>
 #include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 namespace p2p
 {
+  // Outbound ENet client. The host and peer belong to a single I/O thread:
+  // senders only push onto a lock-free submission queue and never wait on a
+  // lock, a connect attempt or the network. Each I/O cycle drains the queue,
+  // flushes the host once for everything drained, then keeps servicing the
+  // host so acks and retransmits advance between submissions.
+  //
+  // Connecting never blocks either: the I/O thread steps a connection_state
+  // machine. Submissions made while not connected wait in a bounded buffer,
+  // where unreliable messages sharing a coalesce key keep only the newest,
+  // and go out in order as soon as the peer accepts the connection.
   class udp_client
   {
   public:
+    // Submissions the queue holds before send_*() starts dropping
+    static constexpr size_t kSubmitQueueCapacity = 1024;
+    // Messages held while connecting before new ones are dropped
+    static constexpr size_t kPendingCapacity = 256;
+
     udp_client(udp_client_configuration config);
     ~udp_client();
 
+    // Wake the I/O thread; submissions already do this.
     void flush_pending_messages();
 
+    // Any thread; never blocks.
     void send_reliable(message message);
     void send_unreliable(message message);
 
+    connection_state state() const
+    {
+      return state_.load(std::memory_order_relaxed);
+    }
+
+    // Emitted on the I/O thread on every state transition.
+    utils::event_emitter<connection_state> on_state_changed;
+
   private:
     // Channel layout: keep unreliable traffic separate from reliable to
     // minimize head-of-line blocking when losses occur on the reliable path.
     static constexpr enet_uint8 kChannelUnreliable = 0;
     static constexpr enet_uint8 kChannelReliable = 1;
+    // How long the I/O thread sleeps between host services while a
+    // connection is up or being set up
+    static constexpr int kServiceIntervalMs = 1;
+    static constexpr unsigned long long kConnectTimeoutMs = 500;
+    // Backoff after a failed or lost connection doubles up to the maximum
+    static constexpr unsigned long long kBackoffInitialMs = 250;
+    static constexpr unsigned long long kBackoffMaxMs = 4000;
+
+    struct submission
+    {
+      std::string payload;
+      uint64_t timestamp_ns = 0; // latency reference, see message
+      uint32_t coalesce_key = 0;
+      bool reliable = false;
+    };
 
     udp_client_configuration config_;
+
+    // I/O thread state; nothing below is touched by other threads
     ENetHost* host_{nullptr};
     ENetPeer* peer_{nullptr};
-    std::mutex mutex_; // guards host_/peer_ and all ENet calls
 
-    // Reconnect support
-    unsigned long long last_connect_attempt_ms_{0};
-    int reconnect_interval_ms_{1000}; // 1s between attempts
-    int connect_timeout_ms_{500};
+    // Connection state machine
+    unsigned long long connect_deadline_ms_{0};
+    unsigned long long backoff_until_ms_{0};
+    unsigned long long backoff_ms_{kBackoffInitialMs};
+    // Submissions waiting for the connection, oldest first
+    std::deque<submission> pending_;
 
-    // Precondition: mutex_ is held by caller
-    bool ensure_connected();
-    unsigned long long now_ms() const;
+    // Capture timestamps of the packets in the current flush
+    std::vector<uint64_t> sent_stamps_;
+
+    // Shared with producers
+    utils::mpsc_queue<submission, kSubmitQueueCapacity> submissions_;
+    std::thread io_thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> parked_{false};
+    std::atomic<connection_state> state_{connection_state::idle};
+    std::mutex wake_m_;
+    std::condition_variable wake_cv_;
 
-    void send_impl(message message, bool is_reliable);
+    void submit(message msg, bool is_reliable);
+    void wake();
 
-    // Precondition: mutex_ is held by caller; services ENet events with a
-    // small budget to advance acks/timeouts and detect disconnects.
-    void flush_service_events();
+    void io_loop();
+    // Send everything queued, or hold it while not connected, and flush
+    // once. Returns the number of packets handed to ENet.
+    size_t drain_submissions();
+    void hold(submission&& s);
+    bool send_one(submission& s);
+    // Services ENet events without blocking to advance acks/timeouts and
+    // the connection state.
+    void service_events();
+    void park();
+
+    // Connection state machine steps
+    void step_connection();
+    void begin_connect();
+    void on_connected();
+    void on_connection_lost(const char* reason);
+    void set_state(connection_state next);
+    void disconnect();
+    unsigned long long now_ms() const;
   };
-} // namespace p2p
\ No newline at end of file
+} // namespace p2p
@@ -1,17 +1,25 @@
 #include "networking/p2p/udp_server.h"
 
+#include "utils/latency/latency.h"
+#include "utils/log/log.h"
+
 #include <enet/enet.h>
-#include <iostream>
+#include <memory>
 
 namespace p2p
 {
-  void udp_server::destroy_packet(ENetPacket* packet)
+  namespace
   {
-    if (packet)
+    struct packet_deleter
     {
-      enet_packet_destroy(packet);
-    }
-  }
+      void operator()(ENetPacket* packet) const
+      {
+        enet_packet_destroy(packet);
+      }
+    };
+    // Owns a received packet; messages borrow its bytes until it goes
+    using packet_handle = std::unique_ptr<ENetPacket, packet_deleter>;
+  } // namespace
 
   std::string udp_server::extract_ip(ENetPeer* peer)
   {
@@ -36,7 +44,7 @@ namespace p2p
   {
     if (enet_initialize() != 0)
     {
-      std::cerr << "[udp_server] enet_initialize failed" << std::endl;
+      KP_LOG_ERROR("udp_server", "enet_initialize failed");
       return;
     }
     enet_inited_ = true;
@@ -51,18 +59,24 @@ namespace p2p
                              /* outgoing bandwidth */ 0);
     if (!host_)
     {
-      std::cerr << "[udp_server] Failed to create ENet host on port "
-                << config_.get_port() << std::endl;
+      KP_LOG_ERROR("udp_server", "Failed to create ENet host on port "
+                                     << config_.get_port());
     }
     else
     {
-      std::cout << "[udp_server] Listening on port " << config_.get_port()
-                << std::endl;
+      KP_LOG_INFO("udp_server", "Listening on port " << config_.get_port());
+      running_.store(true, std::memory_order_relaxed);
+      receive_thread_ = std::thread(&udp_server::receive_loop, this);
     }
   }
 
   udp_server::~udp_server()
   {
+    running_.store(false, std::memory_order_relaxed);
+    if (receive_thread_.joinable())
+    {
+      receive_thread_.join();
+    }
     if (host_)
     {
       enet_host_destroy(host_);
@@ -75,56 +89,52 @@ namespace p2p
     }
   }
 
-  void udp_server::poll_events()
+  void udp_server::receive_loop()
   {
-    if (!host_)
+    ENetEvent event;
+    while (running_.load(std::memory_order_relaxed))
+    {
+      // Blocks in the socket wait until a datagram arrives or the timeout
+      // passes; the timeout only bounds shutdown and ENet's own upkeep.
+      const int rc = enet_host_service(host_, &event, kServiceTimeoutMs);
+      if (rc < 0)
+      {
+        KP_LOG_ERROR("udp_server", "enet_host_service failed");
+        continue;
+      }
+      if (rc > 0 && event.type == ENET_EVENT_TYPE_RECEIVE)
+      {
+        handle_receive(event);
+      }
+    }
+  }
+
+  void udp_server::handle_receive(ENetEvent& event)
+  {
+    const packet_handle packet(event.packet);
+    std::string from_ip = extract_ip(event.peer);
+    if (from_ip.empty())
     {
-      std::cerr << "[udp_server] poll_events called with null host"
-                << std::endl;
+      KP_LOG_WARN("udp_server", "Failed to get from IP address");
       return;
     }
 
-    ENetEvent event;
-    // Service pending events with a bounded budget to avoid hogging UI thread,
-    // but high enough to keep latency low under bursts
-    const int kMaxPerPoll = 64; // cap processed events per frame
-    int processed = 0;
-    while (processed < kMaxPerPoll && enet_host_service(host_, &event, 0) > 0)
+    KP_LOG_TRACE("udp_server",
+                 "Received packet of length "
+                     << (packet ? packet->dataLength : 0) << " bytes from "
+                     << from_ip);
+
+    message msg;
+    msg.set_timestamp_ns(utils::latency::now_ns());
+    msg.set_from(p2p::peer{from_ip});
+    msg.set_to(p2p::peer::self());
+
+    if (packet && packet->data && packet->dataLength > 0)
     {
-      if (event.type == ENET_EVENT_TYPE_RECEIVE)
-      {
-        std::string from_ip = extract_ip(event.peer);
-        if (from_ip.empty())
-        {
-          std::cerr << "Failed to get from IP address" << std::endl;
-          destroy_packet(event.packet);
-          continue;
-        }
-
-        // Avoid excessive logging on hot path; uncomment for debugging
-        // std::cout << "[udp_server] Received packet of length "
-        //           << (event.packet ? event.packet->dataLength : 0)
-        //           << " bytes from " << from_ip << std::endl;
-
-        message msg;
-        p2p::peer from_peer{from_ip};
-        p2p::peer to_peer = p2p::peer::self();
-        msg.set_from(from_peer);
-        msg.set_to(to_peer);
-
-        if (event.packet && event.packet->data && event.packet->dataLength > 0)
-        {
-          const char* data = reinterpret_cast<const char*>(event.packet->data);
-          msg.set_payload(std::string(data, event.packet->dataLength));
-          // std::cout << "[udp_server] Payload (truncated 256): "
-          //           << msg.get_payload().substr(0, 256) << std::endl;
-        }
-
-        // std::cout << "[udp_server] Emitting on_message" << std::endl;
-        on_message.emit(msg);
-        destroy_packet(event.packet);
-      }
-      ++processed;
+      // Subscribers decode in place; the packet is released after emit()
+      msg.set_payload_view(packet->data, packet->dataLength);
     }
+
+    on_message.emit(msg);
   }
 } // namespace p2p
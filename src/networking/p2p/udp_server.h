@@ -4,26 +4,39 @@
 #include "./udp_server_configuration.h"
 #include "utils/event_emitter/event_emitter.h"
 
+#include <atomic>
 #include <enet/enet.h>
+#include <string>
+#include <thread>
 
 namespace p2p
 {
+  // Inbound ENet host. A dedicated receive thread owns the host and sleeps
+  // in enet_host_service until a datagram arrives, so packets are handed on
+  // as soon as they land and an idle server uses no CPU.
   class udp_server
   {
   public:
     udp_server(udp_server_configuration config);
     ~udp_server();
 
-    void poll_events();
-
+    // Emitted on the receive thread, once per received packet. The message
+    // borrows the packet's bytes, which are freed when emit() returns.
     utils::event_emitter<message> on_message;
 
   private:
+    // Longest the receive thread blocks; bounds shutdown latency.
+    static constexpr enet_uint32 kServiceTimeoutMs = 100;
+
     udp_server_configuration config_;
     ENetHost* host_{nullptr};
     bool enet_inited_{false};
 
-    void destroy_packet(ENetPacket* packet);
+    std::thread receive_thread_;
+    std::atomic<bool> running_{false};
+
+    void receive_loop();
+    void handle_receive(ENetEvent& event);
     std::string extract_ip(ENetPeer* peer);
   };
 } // namespace p2p
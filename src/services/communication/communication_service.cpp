@@ -1,140 +1,201 @@
 #include "./communication_service.h"
 
-#include <iostream>
+#include "utils/latency/latency.h"
+#include "utils/log/log.h"
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
 
 namespace services
 {
-  communication_service::communication_service() = default;
+  communication_service::communication_service(
+      p2p::transport_kind transport,
+      std::chrono::microseconds loopback_latency)
+      : transport_kind_(transport), loopback_latency_(loopback_latency)
+  {
+  }
 
   communication_service::~communication_service() = default;
 
   void communication_service::init()
   {
     p2p::udp_server_configuration server_config;
-    server_config.set_port(default_communication_port_);
+    server_config.set_port(communication_port_);
 
-    udp_server_ = std::make_shared<p2p::udp_server>(server_config);
-
-    std::cout << "[communication_service] Initialized server on port "
-              << default_communication_port_ << std::endl;
-
-    udp_server_->on_message.subscribe(
+    transport_ = p2p::make_transport(transport_kind_, loopback_latency_);
+    transport_->on_message.subscribe(
         [this](const p2p::message& msg)
         {
-          std::cout << "[communication_service] on_message from "
-                    << msg.get_from().get_ip_address() << " -> self "
-                    << msg.get_to().get_ip_address()
-                    << ", payload size=" << msg.get_payload().size()
-                    << std::endl;
-          if (pinned_peer_ &&
-              msg.get_from().get_ip_address() != pinned_peer_->get_ip_address())
+          KP_LOG_DEBUG("communication_service",
+                       "on_message from " << msg.get_from().get_ip_address()
+                                          << " -> self "
+                                          << msg.get_to().get_ip_address()
+                                          << ", payload size="
+                                          << msg.get_payload_size());
+          // Runs on the server's receive thread; pin/unpin swap the peer
+          const auto pinned = std::atomic_load(&pinned_peer_);
+          if (pinned &&
+              msg.get_from().get_ip_address() != pinned->get_ip_address())
           {
-            std::cout << "[communication_service] Ignoring message from "
-                      << msg.get_from().get_ip_address() << " (not pinned peer)"
-                      << std::endl;
+            KP_LOG_DEBUG("communication_service",
+                         "Ignoring message from "
+                             << msg.get_from().get_ip_address()
+                             << " (not pinned peer)");
             return;
           }
 
-          typed_package package = typed_package::decode(msg.get_payload());
-          package.meta = msg;
-
-          std::cout << "[communication_service] Decoded package type='"
-                    << package.__typename
-                    << "' payload_size=" << package.payload.size() << std::endl;
+          // The package borrows the message's payload, which is only valid
+          // until this callback returns; subscribers decode it in place.
+          typed_package package;
+          if (!typed_package::decode_view(msg.get_payload_data(),
+                                          msg.get_payload_size(), package))
+          {
+            KP_LOG_DEBUG("communication_service",
+                         "Ignoring malformed package of "
+                             << msg.get_payload_size() << " bytes");
+            return;
+          }
+          package.meta.set_from(msg.get_from());
+          package.meta.set_to(msg.get_to());
+          package.meta.set_timestamp_ns(msg.get_timestamp_ns());
+          utils::latency::record_since(
+              utils::latency::stage::receive_to_decode,
+              msg.get_timestamp_ns());
+
+          KP_LOG_DEBUG("communication_service",
+                       "Decoded package type='"
+                           << package_type_name(package.type)
+                           << "' payload_size=" << package.payload_size());
 
           on_package.emit(package);
         });
+    transport_->on_state_changed.subscribe(
+        [this](const p2p::connection_state& state)
+        { on_connection_state.emit(state); });
+    transport_->listen(server_config);
+
+    KP_LOG_INFO("communication_service",
+                "Initialized " << transport_->name() << " transport on port "
+                               << communication_port_);
   }
 
   void communication_service::update()
   {
-    udp_server_->poll_events();
-    if (udp_client_)
+    // The transport sends and receives on its own threads
+    if (utils::latency::dump_due())
     {
-      udp_client_->flush_pending_messages();
+      std::ostringstream latency;
+      utils::latency::dump(latency);
+      std::string report = latency.str();
+      if (!report.empty())
+      {
+        report.pop_back(); // the writer ends the line
+        KP_LOG_INFO("communication_service", "Input latency:\n" << report);
+      }
     }
+    on_update.emit();
   }
 
   void communication_service::cleanup()
   {
-    if (udp_server_)
-    {
-      udp_server_.reset();
-    }
-    if (udp_client_)
-    {
-      udp_client_.reset();
-    }
+    transport_.reset();
+  }
+
+  void communication_service::set_port(int port)
+  {
+    communication_port_ = port;
   }
 
   void communication_service::pin_connection(p2p::peer target_peer)
   {
-    pinned_peer_ = std::make_shared<p2p::peer>(target_peer);
-    std::cout << "[communication_service] Pinned peer "
-              << pinned_peer_->get_ip_address() << std::endl;
+    std::atomic_store(&pinned_peer_, std::make_shared<p2p::peer>(target_peer));
+    KP_LOG_INFO("communication_service", "Pinned peer "
+                                             << target_peer.get_ip_address());
 
     p2p::udp_client_configuration config;
-    config.set_port(default_communication_port_);
-    config.set_peer(*pinned_peer_);
+    config.set_port(communication_port_);
+    config.set_peer(target_peer);
 
-    udp_client_ = std::make_shared<p2p::udp_client>(config);
-    std::cout << "[communication_service] Created UDP client for pinned peer"
-              << std::endl;
+    if (transport_)
+    {
+      transport_->connect(config);
+    }
   }
 
   void communication_service::unpin_connection()
   {
-    pinned_peer_ = nullptr;
+    std::atomic_store(&pinned_peer_, std::shared_ptr<p2p::peer>());
 
-    if (udp_client_)
+    if (transport_)
     {
-      udp_client_.reset();
+      transport_->disconnect();
     }
   }
 
   void
   communication_service::send_package_reliable(const typed_package& package)
   {
-    if (!udp_client_ || !pinned_peer_)
+    const auto pinned = std::atomic_load(&pinned_peer_);
+    if (!transport_ || !pinned)
     {
-      std::cerr << "Unable to send reliable package: No UDP client or pinned "
-                   "peer available."
-                << std::endl;
+      KP_LOG_WARN("communication_service",
+                  "Unable to send package: No transport or pinned peer "
+                  "available.");
       return;
     }
 
-    std::cout << "[communication_service] Sending reliable package type='"
-              << package.__typename << "' size=" << package.payload.size()
-              << " to " << pinned_peer_->get_ip_address() << std::endl;
+    KP_LOG_DEBUG("communication_service",
+                 "Sending reliable package type='"
+                     << package_type_name(package.type)
+                     << "' size=" << package.payload.size() << " to "
+                     << pinned->get_ip_address());
 
     p2p::message msg;
     msg.set_from(p2p::peer::self());
-    msg.set_to(*pinned_peer_);
+    msg.set_to(*pinned);
     msg.set_payload(package.encode());
+    msg.set_timestamp_ns(package.meta.get_timestamp_ns());
 
-    udp_client_->send_reliable(msg);
+    transport_->send(std::move(msg), p2p::traffic_class::reliable);
   }
 
   void
   communication_service::send_package_unreliable(const typed_package& package)
   {
-    if (!udp_client_ || !pinned_peer_)
+    const auto pinned = std::atomic_load(&pinned_peer_);
+    if (!transport_ || !pinned)
     {
-      std::cerr << "Unable to send reliable package: No UDP client or pinned "
-                   "peer available."
-                << std::endl;
+      KP_LOG_WARN("communication_service",
+                  "Unable to send package: No transport or pinned peer "
+                  "available.");
       return;
     }
 
-    std::cout << "[communication_service] Sending unreliable package type='"
-              << package.__typename << "' size=" << package.payload.size()
-              << " to " << pinned_peer_->get_ip_address() << std::endl;
+    KP_LOG_DEBUG("communication_service",
+                 "Sending unreliable package type='"
+                     << package_type_name(package.type)
+                     << "' size=" << package.payload.size() << " to "
+                     << pinned->get_ip_address());
 
     p2p::message msg;
     msg.set_from(p2p::peer::self());
-    msg.set_to(*pinned_peer_);
+    msg.set_to(*pinned);
     msg.set_payload(package.encode());
+    msg.set_timestamp_ns(package.meta.get_timestamp_ns());
+    // Only the newest package of a self-superseding type is worth sending
+    // late; redundant key copies must each go out
+    if (package_type_supersedes(package.type))
+    {
+      msg.set_coalesce_key(static_cast<uint32_t>(package.type));
+    }
 
-    udp_client_->send_unreliable(msg);
+    transport_->send(std::move(msg), p2p::traffic_class::unreliable);
+  }
+
+  p2p::transport::stats communication_service::get_transport_stats() const
+  {
+    return transport_ ? transport_->get_stats() : p2p::transport::stats{};
   }
 } // namespace services
\ No newline at end of file
@@ -2,10 +2,10 @@
 
 #include "./typed_package.h"
 #include "networking/p2p/peer.h"
-#include "networking/p2p/udp_client.h"
-#include "networking/p2p/udp_server.h"
+#include "networking/p2p/transport.h"
 #include "services/service_lifecycle_listener.h"
 
+#include <chrono>
 #include <memory>
 
 namespace services
@@ -13,12 +13,32 @@ namespace services
   class communication_service : public service_lifecycle_listener
   {
   public:
-    communication_service();
+    // The transport is created in init() and destroyed in cleanup();
+    // 'loopback_latency' only applies to p2p::transport_kind::loopback.
+    explicit communication_service(
+        p2p::transport_kind transport = p2p::transport_kind::enet,
+        std::chrono::microseconds loopback_latency =
+            std::chrono::microseconds(0));
     ~communication_service();
 
     void init() override;
     void update() override;
     void cleanup() override;
+    // Packets arrive on the transport's own thread; update() only drives
+    // on_update timeouts, the shortest of which is ReceiverFlow's 25 ms
+    // motion fence.
+    std::chrono::milliseconds tick_interval() const override
+    {
+      return std::chrono::milliseconds(5);
+    }
+    const char* service_name() const override
+    {
+      return "communication_service";
+    }
+
+    // Port to listen on and to reach the pinned peer at. Takes effect on
+    // the next init() and pin_connection().
+    void set_port(int port);
 
     void pin_connection(p2p::peer target_peer);
     void unpin_connection();
@@ -26,14 +46,28 @@ namespace services
     void send_package_reliable(const typed_package& package);
     void send_package_unreliable(const typed_package& package);
 
+    // Counters of the current transport; zeros before init().
+    p2p::transport::stats get_transport_stats() const;
+
+    // Emitted on the transport's receive thread. The package borrows the
+    // received bytes: read it through payload_data()/payload_size() and
+    // keep nothing from it past the callback.
     utils::event_emitter<services::typed_package> on_package;
     utils::event_emitter<void> on_disconnect;
+    // Fired at the end of every update() on the services thread, i.e. every
+    // tick_interval(), for periodic checks that must run even when no
+    // packages arrive.
+    utils::event_emitter<void> on_update;
+    // Pinned connection state changes, emitted on the transport's thread.
+    utils::event_emitter<p2p::connection_state> on_connection_state;
 
   private:
-    std::shared_ptr<p2p::udp_server> udp_server_;
-    std::shared_ptr<p2p::udp_client> udp_client_;
+    p2p::transport_kind transport_kind_;
+    std::chrono::microseconds loopback_latency_;
+    std::unique_ptr<p2p::transport> transport_;
+    // Read by the receive thread; swap with std::atomic_store
     std::shared_ptr<p2p::peer> pinned_peer_;
 
-    int default_communication_port_ = 8801;
+    int communication_port_ = 8801;
   };
 } // namespace services
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+namespace services
+{
+  // Wire ids for typed_package payloads. Every package struct exposes its id
+  // as `static constexpr package_type type`, so dispatch is an integer compare.
+  // Ids are part of the protocol: never renumber, only append.
+  enum class package_type : uint16_t
+  {
+    unknown = 0,
+    keyboard_input = 1,
+    become_receiver = 2,
+    input_batch = 3,
+    motion = 4,
+    key_state = 5,
+  };
+
+  inline const char* package_type_name(package_type type)
+  {
+    switch (type)
+    {
+    case package_type::keyboard_input:
+      return "keyboard_input";
+    case package_type::become_receiver:
+      return "become_receiver";
+    case package_type::input_batch:
+      return "input_batch";
+    case package_type::motion:
+      return "motion";
+    case package_type::key_state:
+      return "key_state";
+    default:
+      return "unknown";
+    }
+  }
+
+  // True for types where the newest package carries everything the older
+  // ones did (motion totals, key state snapshots), so unsent older ones can
+  // be dropped. Individual events never qualify.
+  inline bool package_type_supersedes(package_type type)
+  {
+    return type == package_type::motion || type == package_type::key_state;
+  }
+} // namespace services
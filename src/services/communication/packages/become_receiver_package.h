@@ -1,50 +1,57 @@
 #pragma once
 
 #include "services/communication/typed_package.h"
+#include "utils/serialization/serialization.h"
 
-#include <iostream>
-#include <nlohmann/json.hpp>
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <tuple>
 
 namespace services
 {
 
   struct become_receiver_package
   {
-    static constexpr const char* __typename = "become_receiver";
+    static constexpr package_type type = package_type::become_receiver;
 
-    static bool is(services::typed_package pkg)
+    static bool is(const services::typed_package& pkg)
     {
-      return pkg.__typename == __typename;
+      return pkg.type == type;
     }
 
-    std::string device_id;
+    uint64_t device_id = 0; // sender's discovery_peer::device_id
+
+    static constexpr auto fields()
+    {
+      using utils::serialization::field;
+      return std::make_tuple(
+          field(1, "device_id", &become_receiver_package::device_id));
+    }
 
     inline std::string encode() const
     {
-      nlohmann::json j{{"device_id", device_id}};
-      return j.dump();
+      return utils::serialization::encode_binary(*this);
     }
 
-    static inline become_receiver_package decode(const std::string& s)
+    // Accepts the binary encoding as well as JSON from older peers. Returns a
+    // default package on malformed input.
+    static inline become_receiver_package decode(const uint8_t* data,
+                                                 size_t size)
     {
       become_receiver_package p{};
-      auto j = nlohmann::json::parse(s, nullptr, false);
-      if (!j.is_object())
-      {
-        std::cerr
-            << "[become_receiver_package] Decode failed: not a JSON object"
-            << std::endl;
-        return p;
-      }
-      if (j.contains("device_id") && j["device_id"].is_string())
-      {
-        p.device_id = j.value("device_id", std::string{});
-        std::cout << "[become_receiver_package] Decoded device_id='"
-                  << p.device_id << "'" << std::endl;
-      }
-      return p;
+      const bool ok =
+          (size > 0 && data[0] == '{')
+              ? utils::serialization::decode_json(
+                    std::string(reinterpret_cast<const char*>(data), size), p)
+              : utils::serialization::decode_binary(data, size, p);
+      return ok ? p : become_receiver_package{};
+    }
+
+    static inline become_receiver_package decode(const std::string& s)
+    {
+      return decode(reinterpret_cast<const uint8_t*>(s.data()), s.size());
     }
   };
 
-} // namespace services
\ No newline at end of file
+} // namespace services
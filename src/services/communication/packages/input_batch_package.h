@@ -0,0 +1,48 @@
+#pragma once
+
+#include "keyboard/event_batch.h"
+#include "services/communication/typed_package.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace services
+{
+  struct input_batch_package
+  {
+    static constexpr package_type type = package_type::input_batch;
+
+    keyboard::EventBatch batch;
+
+    inline std::string encode() const { return batch.encode(); }
+
+    // Decodes into 'out', reusing its event storage. Returns false on
+    // malformed input.
+    static inline bool decode(const uint8_t* data, size_t size,
+                              input_batch_package& out)
+    {
+      return keyboard::EventBatch::decode(data, size, out.batch);
+    }
+
+    static inline input_batch_package decode(const std::string& s)
+    {
+      input_batch_package p{};
+      p.batch = keyboard::EventBatch::decode(s);
+      return p;
+    }
+
+    static bool is(const services::typed_package& pkg)
+    {
+      return pkg.type == type;
+    }
+
+    static inline typed_package build(const keyboard::EventBatch& batch)
+    {
+      typed_package p{};
+      p.type = type;
+      p.payload = batch.encode();
+      return p;
+    }
+  };
+} // namespace services
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "keyboard/pressed_state.h"
+#include "services/communication/typed_package.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace services
+{
+  // Periodic pressed-keys snapshot, sent unreliably; see
+  // keyboard::PressedStateSync.
+  struct key_state_package
+  {
+    static constexpr package_type type = package_type::key_state;
+
+    keyboard::PressedStateSync sync;
+
+    inline std::string encode() const { return sync.encode(); }
+
+    // Returns false on malformed input.
+    static inline bool decode(const uint8_t* data, size_t size,
+                              key_state_package& out)
+    {
+      return keyboard::PressedStateSync::decode(data, size, out.sync);
+    }
+
+    static inline bool decode(const std::string& s, key_state_package& out)
+    {
+      return keyboard::PressedStateSync::decode(s, out.sync);
+    }
+
+    static bool is(const services::typed_package& pkg)
+    {
+      return pkg.type == type;
+    }
+
+    static inline typed_package build(const keyboard::PressedStateSync& sync)
+    {
+      typed_package p{};
+      p.type = type;
+      p.payload = sync.encode();
+      return p;
+    }
+  };
+} // namespace services
@@ -3,39 +3,69 @@
 #include "keyboard/input_event.h"
 #include "services/communication/typed_package.h"
 
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
 namespace services
 {
   struct keyboard_input_package
   {
-    static constexpr const char* __typename = "keyboard_input";
+    static constexpr package_type type = package_type::keyboard_input;
+
+    // Debug fallback: send events as JSON instead of the binary codec.
+    // Receivers accept both encodings regardless of this flag.
+    static constexpr bool kUseJsonWire = false;
 
     keyboard::InputEvent event;
 
     inline std::string encode() const
     {
-      return keyboard::InputEventJSONConverter::encode(event);
+      if (kUseJsonWire)
+      {
+        return keyboard::InputEventJSONConverter::encode(event);
+      }
+      uint8_t buf[keyboard::InputEventBinaryConverter::kEncodedSize];
+      const size_t n =
+          keyboard::InputEventBinaryConverter::encode(event, buf, sizeof(buf));
+      return std::string(reinterpret_cast<const char*>(buf), n);
     }
 
-    static inline keyboard_input_package decode(const std::string& s)
+    // Accepts the binary encoding as well as JSON. Returns false on
+    // malformed input.
+    static inline bool decode(const uint8_t* data, size_t size,
+                              keyboard_input_package& out)
     {
-      keyboard_input_package p{};
-      p.event = keyboard::InputEventJSONConverter::decode(s);
-      return p;
+      if (size > 0 && data[0] == '{')
+      {
+        return keyboard::InputEventJSONConverter::decode(
+            std::string(reinterpret_cast<const char*>(data), size),
+            out.event);
+      }
+      return keyboard::InputEventBinaryConverter::decode(data, size,
+                                                         out.event);
+    }
+
+    static inline bool decode(const std::string& s,
+                              keyboard_input_package& out)
+    {
+      return decode(reinterpret_cast<const uint8_t*>(s.data()), s.size(),
+                    out);
     }
 
-    static bool is(services::typed_package pkg)
+    static bool is(const services::typed_package& pkg)
     {
-      return pkg.__typename == __typename;
+      return pkg.type == type;
     }
 
     static inline typed_package build(const keyboard::InputEvent& e)
     {
       typed_package p{};
-      p.__typename = __typename;
+      p.type = type;
       keyboard_input_package kip;
       kip.event = e;
       p.payload = kip.encode();
       return p;
     }
   };
-} // namespace services
\ No newline at end of file
+} // namespace services
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "keyboard/motion_stream.h"
+#include "services/communication/typed_package.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace services
+{
+  // Pointer motion and scroll, sent unreliably; see keyboard::MotionFrame
+  // for how loss and reordering are absorbed.
+  struct motion_package
+  {
+    static constexpr package_type type = package_type::motion;
+
+    keyboard::MotionFrame frame;
+
+    inline std::string encode() const { return frame.encode(); }
+
+    // Returns false on malformed input.
+    static inline bool decode(const uint8_t* data, size_t size,
+                              motion_package& out)
+    {
+      return keyboard::MotionFrame::decode(data, size, out.frame);
+    }
+
+    static inline bool decode(const std::string& s, motion_package& out)
+    {
+      return keyboard::MotionFrame::decode(s, out.frame);
+    }
+
+    static bool is(const services::typed_package& pkg)
+    {
+      return pkg.type == type;
+    }
+
+    static inline typed_package build(const keyboard::MotionFrame& frame)
+    {
+      typed_package p{};
+      p.type = type;
+      p.payload = frame.encode();
+      return p;
+    }
+  };
+} // namespace services
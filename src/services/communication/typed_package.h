@@ -1,43 +1,147 @@
 #pragma once
 
+#include "./package_type.h"
 #include "networking/p2p/message.h"
+#include "utils/byte_order/byte_order.h"
 
-#include <nlohmann/json.hpp>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 namespace services
 {
+  // Binary envelope around a package payload.
+  //
+  // Header (8 bytes, little-endian), followed by `length` raw payload bytes:
+  //   [0..1] u16 magic ('K' 'P')
+  //   [2]    u8  version
+  //   [3]    u8  flags (reserved, 0)
+  //   [4..5] u16 package type id
+  //   [6..7] u16 payload length
+  //
+  // Packages being built own their payload. Received packages are decoded
+  // with decode_view() and borrow it from the message instead, so readers
+  // go through payload_data()/payload_size(), which cover both.
   struct typed_package
   {
   public:
-    std::string __typename;
+    static constexpr uint16_t kMagic = 0x504B; // "KP" on the wire
+    static constexpr uint8_t kVersion = 1;
+    static constexpr size_t kHeaderSize = 8;
+    static constexpr size_t kMaxPayloadSize = 0xFFFF;
+
+    package_type type = package_type::unknown;
+    // Owned payload; empty for a package from decode_view()
     std::string payload;
 
+    // Addressing and timestamp; received packages carry no payload here
     p2p::message meta;
 
-    inline std::string encode() const
+    inline const uint8_t* payload_data() const
     {
-      nlohmann::json j{{"__typename", __typename}, {"payload", payload}};
-      return j.dump();
+      return borrowed_ ? view_data_
+                       : reinterpret_cast<const uint8_t*>(payload.data());
     }
 
-    static inline typed_package decode(const std::string& s)
+    inline size_t payload_size() const
     {
-      typed_package p{};
-      auto j = nlohmann::json::parse(s, nullptr, false);
-      if (!j.is_object())
+      return borrowed_ ? view_size_ : payload.size();
+    }
+
+    // Encode into a caller-provided buffer. Returns bytes written, or 0 when
+    // the buffer is too small or the payload does not fit the length field.
+    inline size_t encode(uint8_t* out, size_t cap) const
+    {
+      namespace bo = utils::byte_order;
+      const size_t total = kHeaderSize + payload.size();
+      if (!out || cap < total || payload.size() > kMaxPayloadSize)
+      {
+        return 0;
+      }
+      bo::put_u16(out, kMagic);
+      out[2] = kVersion;
+      out[3] = 0;
+      bo::put_u16(out + 4, static_cast<uint16_t>(type));
+      bo::put_u16(out + 6, static_cast<uint16_t>(payload.size()));
+      if (!payload.empty())
       {
-        return p;
+        payload.copy(reinterpret_cast<char*>(out + kHeaderSize),
+                     payload.size());
       }
-      if (j.contains("__typename") && j["__typename"].is_string())
+      return total;
+    }
+
+    inline std::string encode() const
+    {
+      std::string out(kHeaderSize + payload.size(), '\0');
+      if (encode(reinterpret_cast<uint8_t*>(&out[0]), out.size()) == 0)
+      {
+        return {};
+      }
+      return out;
+    }
+
+    // Decode an envelope. Returns false on bad magic, unknown version or a
+    // truncated payload.
+    static inline bool decode(const uint8_t* data, size_t size,
+                              typed_package& out)
+    {
+      size_t length = 0;
+      if (!decode_header(data, size, out.type, length))
       {
-        p.__typename = j.value("__typename", std::string{});
+        return false;
       }
-      if (j.contains("payload") && j["payload"].is_string())
+      out.payload.assign(reinterpret_cast<const char*>(data + kHeaderSize),
+                         length);
+      out.borrowed_ = false;
+      return true;
+    }
+
+    // Like decode(), but 'out' points into 'data' instead of copying the
+    // payload; 'data' must outlive 'out'.
+    static inline bool decode_view(const uint8_t* data, size_t size,
+                                   typed_package& out)
+    {
+      size_t length = 0;
+      if (!decode_header(data, size, out.type, length))
       {
-        p.payload = j.value("payload", std::string{});
+        return false;
       }
+      out.payload.clear();
+      out.view_data_ = data + kHeaderSize;
+      out.view_size_ = length;
+      out.borrowed_ = true;
+      return true;
+    }
+
+    static inline typed_package decode(const std::string& s)
+    {
+      typed_package p{};
+      decode(reinterpret_cast<const uint8_t*>(s.data()), s.size(), p);
       return p;
     }
+
+  private:
+    const uint8_t* view_data_ = nullptr;
+    size_t view_size_ = 0;
+    bool borrowed_ = false;
+
+    static inline bool decode_header(const uint8_t* data, size_t size,
+                                     package_type& type, size_t& length)
+    {
+      namespace bo = utils::byte_order;
+      if (!data || size < kHeaderSize || bo::get_u16(data) != kMagic ||
+          data[2] != kVersion)
+      {
+        return false;
+      }
+      length = bo::get_u16(data + 6);
+      if (size - kHeaderSize < length)
+      {
+        return false;
+      }
+      type = static_cast<package_type>(bo::get_u16(data + 4));
+      return true;
+    }
   };
-} // namespace services
\ No newline at end of file
+} // namespace services
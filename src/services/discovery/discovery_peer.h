@@ -1,67 +1,189 @@
 #pragma once
 
-#include <nlohmann/json.hpp>
+#include "utils/byte_order/byte_order.h"
+
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 namespace services
 {
-  enum class discovery_peer_state
+  enum class discovery_peer_state : uint8_t
   {
     idle,
     busy,
     gone
   };
 
+  // 'linux' is a predefined macro under GNU dialects, hence linux_os.
+  enum class discovery_platform : uint8_t
+  {
+    unknown = 0,
+    macos = 1,
+    windows = 2,
+    linux_os = 3
+  };
+
+  inline discovery_platform discovery_platform_from_name(
+      const std::string& name)
+  {
+    if (name == "macos")
+    {
+      return discovery_platform::macos;
+    }
+    if (name == "windows")
+    {
+      return discovery_platform::windows;
+    }
+    if (name == "linux")
+    {
+      return discovery_platform::linux_os;
+    }
+    return discovery_platform::unknown;
+  }
+
+  // Fixed-size part of a beacon; enough to refresh a known peer without
+  // touching the name.
+  struct discovery_beacon_header
+  {
+    uint64_t device_id = 0;
+    uint32_t config_epoch = 0;
+    discovery_peer_state state = discovery_peer_state::idle;
+    discovery_platform platform = discovery_platform::unknown;
+    uint8_t name_length = 0;
+  };
+
+  // A peer as announced by its discovery beacon.
+  //
+  // Beacon (one datagram, little-endian), followed by `name_length` UTF-8
+  // bytes of device name:
+  //   [0..1]   u16 magic ('K' 'B')
+  //   [2]      u8  version
+  //   [3]      u8  state
+  //   [4]      u8  platform
+  //   [5]      u8  name_length
+  //   [6..9]   u32 config_epoch
+  //   [10..17] u64 device_id
+  //
+  // config_epoch only ever grows and must be bumped whenever the name or
+  // platform changes, so listeners can skip the name for beacons whose epoch
+  // they have already seen. Later versions may only append bytes; decoders
+  // ignore anything past the name. The sender's address is not carried: the
+  // listener takes it from the datagram.
   struct discovery_peer
   {
-    std::string device_id;
+    static constexpr uint16_t kMagic = 0x424B; // "KB" on the wire
+    static constexpr uint8_t kVersion = 1;
+    static constexpr size_t kHeaderSize = 18;
+    static constexpr size_t kMaxNameLength = 64;
+    static constexpr size_t kMaxEncodedSize = kHeaderSize + kMaxNameLength;
+
+    uint64_t device_id = 0;
     std::string device_name;
-    std::string ip_address;
-    std::string platform; // macos, windows, linux
+    std::string ip_address; // filled in by the listener, not on the wire
+    discovery_platform platform = discovery_platform::unknown;
     discovery_peer_state state = discovery_peer_state::idle;
+    uint32_t config_epoch = 0;
+
+    // Encode into a caller-provided buffer. Names longer than kMaxNameLength
+    // are cut at a UTF-8 boundary. Returns bytes written, or 0 when the
+    // buffer is too small.
+    inline size_t encode(uint8_t* out, size_t cap) const
+    {
+      namespace bo = utils::byte_order;
+      const size_t name_length = encoded_name_length();
+      const size_t total = kHeaderSize + name_length;
+      if (!out || cap < total)
+      {
+        return 0;
+      }
+      bo::put_u16(out, kMagic);
+      out[2] = kVersion;
+      out[3] = static_cast<uint8_t>(state);
+      out[4] = static_cast<uint8_t>(platform);
+      out[5] = static_cast<uint8_t>(name_length);
+      bo::put_u32(out + 6, config_epoch);
+      bo::put_u64(out + 10, device_id);
+      device_name.copy(reinterpret_cast<char*>(out + kHeaderSize),
+                       name_length);
+      return total;
+    }
 
-    // Encode this discovery_peer into a compact JSON string
     inline std::string encode() const
     {
-      nlohmann::json j{{"device_id", device_id},
-                       {"device_name", device_name},
-                       {"ip_address", ip_address},
-                       {"platform", platform},
-                       {"state", static_cast<int>(state)}};
-      return j.dump();
+      std::string out(kHeaderSize + encoded_name_length(), '\0');
+      encode(reinterpret_cast<uint8_t*>(&out[0]), out.size());
+      return out;
     }
 
-    static inline discovery_peer decode(const std::string& s)
+    // Parse only the fixed header. Returns false on bad magic or version, or
+    // when the datagram is shorter than header plus name. Unknown states
+    // from newer peers degrade to idle.
+    static inline bool decode_header(const uint8_t* data, size_t size,
+                                     discovery_beacon_header& out)
     {
-      discovery_peer p{};
-      auto j = nlohmann::json::parse(s, nullptr, false);
-      if (!j.is_object())
+      namespace bo = utils::byte_order;
+      if (!data || size < kHeaderSize || bo::get_u16(data) != kMagic ||
+          data[2] < kVersion)
       {
-        return p;
+        return false;
       }
+      out.state = data[3] <= static_cast<uint8_t>(discovery_peer_state::gone)
+                      ? static_cast<discovery_peer_state>(data[3])
+                      : discovery_peer_state::idle;
+      out.platform =
+          data[4] <= static_cast<uint8_t>(discovery_platform::linux_os)
+              ? static_cast<discovery_platform>(data[4])
+              : discovery_platform::unknown;
+      out.name_length = data[5];
+      out.config_epoch = bo::get_u32(data + 6);
+      out.device_id = bo::get_u64(data + 10);
+      return size - kHeaderSize >= out.name_length;
+    }
 
-      p.device_id = j.value("device_id", std::string{});
-      p.device_name = j.value("device_name", std::string{});
-      p.ip_address = j.value("ip_address", std::string{});
-      p.platform = j.value("platform", std::string{});
-
-      // Only accept numeric state; ignore non-numeric values
-      if (j.contains("state") && j["state"].is_number_integer())
+    // Parse a full beacon. 'out' is left untouched on failure.
+    static inline bool decode(const uint8_t* data, size_t size,
+                              discovery_peer& out)
+    {
+      discovery_beacon_header header;
+      if (!decode_header(data, size, header))
       {
-        int sv = j.value("state", 0);
-        if (sv == static_cast<int>(discovery_peer_state::idle) ||
-            sv == static_cast<int>(discovery_peer_state::busy) ||
-            sv == static_cast<int>(discovery_peer_state::gone))
-        {
-          p.state = static_cast<discovery_peer_state>(sv);
-        }
-        else
-        {
-          p.state = discovery_peer_state::idle;
-        }
+        return false;
       }
+      out.device_id = header.device_id;
+      out.config_epoch = header.config_epoch;
+      out.state = header.state;
+      out.platform = header.platform;
+      out.device_name.assign(reinterpret_cast<const char*>(data + kHeaderSize),
+                             header.name_length);
+      return true;
+    }
 
+    // Returns a default peer (device_id 0) on malformed input.
+    static inline discovery_peer decode(const std::string& s)
+    {
+      discovery_peer p{};
+      if (!decode(reinterpret_cast<const uint8_t*>(s.data()), s.size(), p))
+      {
+        return discovery_peer{};
+      }
       return p;
     }
+
+  private:
+    inline size_t encoded_name_length() const
+    {
+      if (device_name.size() <= kMaxNameLength)
+      {
+        return device_name.size();
+      }
+      size_t n = kMaxNameLength;
+      // Do not split a multi-byte sequence: back off continuation bytes
+      while (n > 0 && (static_cast<uint8_t>(device_name[n]) & 0xC0) == 0x80)
+      {
+        --n;
+      }
+      return n;
+    }
   };
 } // namespace services
@@ -24,9 +24,10 @@ services::discovery_service::discovery_service() = default;
 
 services::discovery_service::~discovery_service() = default;
 
-void services::discovery_service::remove_stale_peers()
+bool services::discovery_service::remove_stale_peers()
 {
   uint64_t now = utils::date::now();
+  bool removed = false;
 
   auto it = discovered_peers.begin();
   auto ts_it = peer_last_seen_timestamps_.begin();
@@ -38,6 +39,7 @@ void services::discovery_service::remove_stale_peers()
     {
       it = discovered_peers.erase(it);
       ts_it = peer_last_seen_timestamps_.erase(ts_it);
+      removed = true;
     }
     else
     {
@@ -45,14 +47,20 @@ void services::discovery_service::remove_stale_peers()
       ++ts_it;
     }
   }
+  return removed;
 }
 
-bool services::discovery_service::remove_peer_by_device_id(
-    const std::string& device_id)
+std::vector<services::discovery_peer>::iterator
+services::discovery_service::find_peer(uint64_t device_id)
 {
-  auto it = std::find_if(discovered_peers.begin(), discovered_peers.end(),
-                         [&device_id](const discovery_peer& p)
-                         { return p.device_id == device_id; });
+  return std::find_if(discovered_peers.begin(), discovered_peers.end(),
+                      [device_id](const discovery_peer& p)
+                      { return p.device_id == device_id; });
+}
+
+bool services::discovery_service::remove_peer_by_device_id(uint64_t device_id)
+{
+  auto it = find_peer(device_id);
   if (it == discovered_peers.end())
   {
     return false;
@@ -69,9 +77,7 @@ bool services::discovery_service::remove_peer_by_device_id(
 
 bool services::discovery_service::update_peer_state(discovery_peer& peer)
 {
-  auto it = std::find_if(discovered_peers.begin(), discovered_peers.end(),
-                         [&peer](const discovery_peer& p)
-                         { return p.device_id == peer.device_id; });
+  auto it = find_peer(peer.device_id);
 
   uint64_t now = utils::date::now();
 
@@ -84,7 +90,6 @@ bool services::discovery_service::update_peer_state(discovery_peer& peer)
     {
       peer_last_seen_timestamps_[index] = now;
     }
-    remove_stale_peers();
     return false;
   }
   else
@@ -92,7 +97,6 @@ bool services::discovery_service::update_peer_state(discovery_peer& peer)
     // Add new peer
     discovered_peers.push_back(peer);
     peer_last_seen_timestamps_.push_back(now);
-    remove_stale_peers();
     return true;
   }
 }
@@ -107,7 +111,10 @@ void services::discovery_service::broadcast_own_state(bool force)
   if (should_broadcast && broadcast_client_)
   {
     last_broadcast_time_ms_ = now;
-    broadcast_client_->broadcast(self_peer.encode());
+    uint8_t beacon[discovery_peer::kMaxEncodedSize];
+    const size_t n = self_peer.encode(beacon, sizeof(beacon));
+    broadcast_client_->broadcast(
+        std::string(reinterpret_cast<const char*>(beacon), n));
   }
 }
 
@@ -125,15 +132,81 @@ void services::discovery_service::update_connection_candidates()
                             std::to_string(default_peer_port_));
   }
   store::connection_state().available_devices.set(candidates);
+  candidates_dirty_ = false;
+}
+
+void services::discovery_service::handle_beacon(const p2p::message& msg)
+{
+  const uint8_t* data = msg.get_payload_data();
+  const size_t size = msg.get_payload_size();
+
+  discovery_beacon_header header;
+  if (!discovery_peer::decode_header(data, size, header))
+  {
+    return;
+  }
+
+  // Always trust the packet's real sender IP; the beacon does not carry one.
+  const std::string from_ip = msg.get_from().get_ip_address();
+  if (from_ip == self_ip_address_ || header.device_id == self_peer.device_id)
+  {
+    return;
+  }
+
+  // If a peer declares it has gone, remove it immediately and update UI
+  if (header.state == discovery_peer_state::gone)
+  {
+    candidates_dirty_ |= remove_peer_by_device_id(header.device_id);
+    return;
+  }
+
+  // Known peer whose metadata we already hold (or a reordered older beacon):
+  // refresh liveness and the fixed header fields, leave the name alone.
+  auto it = find_peer(header.device_id);
+  if (it != discovered_peers.end() &&
+      header.config_epoch <= it->config_epoch)
+  {
+    if (it->state != header.state || it->ip_address != from_ip)
+    {
+      it->state = header.state;
+      it->ip_address = from_ip;
+      candidates_dirty_ = true;
+    }
+    const size_t index = std::distance(discovered_peers.begin(), it);
+    if (index < peer_last_seen_timestamps_.size())
+    {
+      peer_last_seen_timestamps_[index] = utils::date::now();
+    }
+    return;
+  }
+
+  discovery_peer peer;
+  if (!discovery_peer::decode(data, size, peer))
+  {
+    return;
+  }
+  peer.ip_address = from_ip;
+
+  bool is_new = update_peer_state(peer);
+  candidates_dirty_ = true;
+  // Optionally, when we first see a new peer, immediately broadcast our
+  // state to accelerate mutual discovery convergence instead of waiting
+  // for the interval.
+  if (is_new)
+  {
+    broadcast_own_state(true);
+  }
 }
 
 void services::discovery_service::init()
 {
-  self_peer.device_id = get_random_id();
+  self_peer.device_id = get_random_device_id();
   self_peer.device_name = get_device_name();
   self_peer.ip_address = self_ip_address_;
-  self_peer.platform = get_platform();
+  self_peer.platform = discovery_platform_from_name(get_platform());
   self_peer.state = discovery_peer_state::idle;
+  // Bump whenever device_name or platform change after this point.
+  self_peer.config_epoch = 1;
 
   p2p::udp_server_configuration config;
   config.set_port(default_peer_port_);
@@ -145,41 +218,8 @@ void services::discovery_service::init()
   broadcast_client_ =
       std::make_unique<p2p::udp_broadcast_client>(client_config);
 
-  broadcast_server_->on_message.subscribe(
-      [this](const p2p::message& msg)
-      {
-        discovery_peer peer = discovery_peer::decode(msg.get_payload());
-        // Always trust the packet's real sender IP so we don't rely on what
-        // the other side put in payload (could be blank).
-        peer.ip_address = msg.get_from().get_ip_address();
-
-        if ((peer.ip_address == self_ip_address_) ||
-            (peer.device_id == self_peer.device_id))
-        {
-          return;
-        }
-
-        // If a peer declares it has gone, remove it immediately and update UI
-        if (peer.state == discovery_peer_state::gone)
-        {
-          if (remove_peer_by_device_id(peer.device_id))
-          {
-            update_connection_candidates();
-          }
-          return;
-        }
-
-        bool is_new = update_peer_state(peer);
-        // Update UI candidates right away so the device appears instantly.
-        update_connection_candidates();
-        // Optionally, when we first see a new peer, immediately broadcast our
-        // state to accelerate mutual discovery convergence instead of waiting
-        // for the interval.
-        if (is_new)
-        {
-          broadcast_own_state(true);
-        }
-      });
+  broadcast_server_->on_message.subscribe([this](const p2p::message& msg)
+                                          { handle_beacon(msg); });
 
   broadcast_own_state(true);
   // Send a second immediate broadcast as a startup burst to accelerate peer
@@ -195,8 +235,11 @@ void services::discovery_service::update()
   }
 
   broadcast_own_state();
-  remove_stale_peers();
-  update_connection_candidates();
+  candidates_dirty_ |= remove_stale_peers();
+  if (candidates_dirty_)
+  {
+    update_connection_candidates();
+  }
 }
 
 void services::discovery_service::cleanup()
@@ -214,4 +257,5 @@ void services::discovery_service::cleanup()
   discovered_peers.clear();
   peer_last_seen_timestamps_.clear();
   last_broadcast_time_ms_ = 0;
+  candidates_dirty_ = false;
 }
\ No newline at end of file
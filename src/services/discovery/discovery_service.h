@@ -4,6 +4,8 @@
 #include "services/discovery/discovery_peer.h"
 #include "services/service_lifecycle_listener.h"
 
+#include <chrono>
+#include <cstdint>
 #include <memory>
 #include <networking/p2p/udp_broadcast_client.h>
 #include <string>
@@ -20,6 +22,13 @@ namespace services
     void init() override;
     void update() override;
     void cleanup() override;
+    // Beacons go out every few seconds; polling for theirs every 50 ms is
+    // plenty.
+    std::chrono::milliseconds tick_interval() const override
+    {
+      return std::chrono::milliseconds(50);
+    }
+    const char* service_name() const override { return "discovery_service"; }
 
     std::vector<discovery_peer> discovered_peers;
     discovery_peer self_peer;
@@ -30,16 +39,22 @@ namespace services
 
     std::vector<uint64_t> peer_last_seen_timestamps_;
 
-    void remove_stale_peers();
+    // Returns true if any peer was dropped.
+    bool remove_stale_peers();
     // Updates or inserts a peer. Returns true if a new peer was added.
     bool update_peer_state(discovery_peer& peer);
+    void handle_beacon(const p2p::message& msg);
     // Broadcast our discovery state. If force is true, bypass interval gating.
     void broadcast_own_state(bool force = false);
     void update_connection_candidates();
 
     // Remove a peer (and its timestamp) by device id. Returns true if found.
-    bool remove_peer_by_device_id(const std::string& device_id);
+    bool remove_peer_by_device_id(uint64_t device_id);
+    std::vector<discovery_peer>::iterator find_peer(uint64_t device_id);
 
+    // Set when the peer list changed; candidates are republished once per
+    // update() instead of once per beacon.
+    bool candidates_dirty_ = false;
     uint64_t last_broadcast_time_ms_ = 0;
     int state_broadcast_interval_ms_ = 5000;
     int peer_stale_timeout_ms_ = 15000;
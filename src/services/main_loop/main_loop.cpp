@@ -3,22 +3,24 @@
 #include "gui/framework/ui_window.h"
 #include "gui/scenes/home/home_scene.h"
 #include "services/service_locator.h"
+#include "utils/log/log.h"
+
+#include <algorithm>
 
 namespace services
 {
-  main_loop::main_loop(/* args */)
-  {
-  }
-
-  main_loop::~main_loop()
+  main_loop::main_loop(bool with_window) : with_window_(with_window)
   {
   }
 
   void main_loop::init()
   {
-    // TODO store gui reference in service locator
-    gui::framework::init_window();
-    gui::framework::set_window_scene<HomeScene>();
+    if (with_window_)
+    {
+      // TODO store gui reference in service locator
+      gui::framework::init_window();
+      gui::framework::set_window_scene<HomeScene>();
+    }
 
     // Init each service
     for (const auto& service :
@@ -30,32 +32,17 @@ namespace services
 
   void main_loop::run()
   {
-    running_ = true;
     // Start background services update loop
     services_running_ = true;
-    services_thread_ = std::thread(
-        []()
-        {
-          using namespace std::chrono_literals;
-          auto& repo = service_locator::instance().repository;
-          while (
-              service_locator::instance().main_loop->services_running_.load())
-          {
-            // Snapshot to avoid holding locks during update()
-            auto snapshot = repo.get_services_snapshot();
-            for (const auto& svc : snapshot)
-            {
-              if (svc)
-              {
-                svc->update();
-              }
-            }
-            std::this_thread::sleep_for(1ms);
-          }
-        });
-
-    while (running_)
+    services_thread_ = std::thread(&main_loop::services_loop, this);
+
+    while (running_.load())
     {
+      if (!with_window_)
+      {
+        std::this_thread::sleep_for(kHeadlessPollInterval);
+        continue;
+      }
       // TODO call shutdown from gui framework when window closes
       if (!gui::framework::window_frame())
       {
@@ -69,13 +56,20 @@ namespace services
     // Stop services thread
     if (services_running_.exchange(false))
     {
+      {
+        std::lock_guard<std::mutex> lock(tasks_m_);
+      }
+      tasks_cv_.notify_one();
       if (services_thread_.joinable())
       {
         services_thread_.join();
       }
     }
 
-    gui::framework::deinit_window();
+    if (with_window_)
+    {
+      gui::framework::deinit_window();
+    }
 
     // Cleanup each service
     for (const auto& service :
@@ -87,7 +81,146 @@ namespace services
 
   void main_loop::shutdown()
   {
-    running_ = false;
+    running_.store(false);
+  }
+
+  void main_loop::post(std::function<void()> task)
+  {
+    {
+      std::lock_guard<std::mutex> lock(tasks_m_);
+      tasks_.push_back(std::move(task));
+    }
+    tasks_cv_.notify_one();
+  }
+
+  void main_loop::services_loop()
+  {
+    next_stats_ = clock::now() + kStatsInterval;
+    while (services_running_.load())
+    {
+      run_tasks();
+      const auto now = clock::now();
+      sync_slots(now);
+      const auto deadline = run_due_services(now);
+      if (clock::now() >= next_stats_)
+      {
+        log_stats();
+        next_stats_ += kStatsInterval;
+      }
+      wait_until(std::min(deadline, next_stats_));
+    }
+  }
+
+  void main_loop::sync_slots(clock::time_point now)
+  {
+    // Snapshot to avoid holding locks during update()
+    const auto services =
+        service_locator::instance().repository.get_services_snapshot();
+
+    std::vector<service_slot> slots;
+    slots.reserve(services.size());
+    for (const auto& svc : services)
+    {
+      if (!svc)
+      {
+        continue;
+      }
+      auto it = std::find_if(slots_.begin(), slots_.end(),
+                             [&](const service_slot& slot)
+                             { return slot.service == svc; });
+      if (it != slots_.end())
+      {
+        slots.push_back(std::move(*it));
+        continue;
+      }
+      slots.push_back(service_slot{
+          svc, now, std::make_unique<utils::latency::histogram>()});
+    }
+    slots_ = std::move(slots);
+  }
+
+  void main_loop::run_tasks()
+  {
+    std::vector<std::function<void()>> tasks;
+    {
+      std::lock_guard<std::mutex> lock(tasks_m_);
+      tasks.swap(tasks_);
+    }
+    for (auto& task : tasks)
+    {
+      if (task)
+      {
+        task();
+      }
+    }
+  }
+
+  main_loop::clock::time_point
+  main_loop::run_due_services(clock::time_point now)
+  {
+    auto earliest = clock::time_point::max();
+    for (auto& slot : slots_)
+    {
+      if (slot.next_due <= now)
+      {
+        const auto start = clock::now();
+        slot.service->update();
+        const auto end = clock::now();
+        const auto took = end - start;
+        slot.durations->record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(took)
+                .count()));
+        if (took > kSlowUpdate)
+        {
+          KP_LOG_WARN(
+              "main_loop",
+              slot.service->service_name()
+                  << " update took "
+                  << std::chrono::duration_cast<std::chrono::microseconds>(
+                         took)
+                         .count()
+                  << " us");
+        }
+
+        // Keep the cadence, but never queue up missed ticks
+        slot.next_due += slot.service->tick_interval();
+        if (slot.next_due <= end)
+        {
+          slot.next_due = end + slot.service->tick_interval();
+        }
+      }
+      earliest = std::min(earliest, slot.next_due);
+    }
+    return earliest;
+  }
+
+  void main_loop::wait_until(clock::time_point deadline)
+  {
+    std::unique_lock<std::mutex> lock(tasks_m_);
+    tasks_cv_.wait_until(lock, deadline,
+                         [this]
+                         {
+                           return !tasks_.empty() ||
+                                  !services_running_.load();
+                         });
+  }
+
+  void main_loop::log_stats()
+  {
+    for (const auto& slot : slots_)
+    {
+      const auto& d = *slot.durations;
+      if (d.count() == 0)
+      {
+        continue;
+      }
+      KP_LOG_INFO("main_loop", slot.service->service_name()
+                                   << " updates n=" << d.count()
+                                   << " p50=" << d.percentile(0.50) / 1000
+                                   << "us p99=" << d.percentile(0.99) / 1000
+                                   << "us max=" << d.max() / 1000 << "us");
+      slot.durations->reset();
+    }
   }
 
 } // namespace services
\ No newline at end of file
@@ -1,27 +1,84 @@
 #pragma once
 
+#include "services/service_lifecycle_listener.h"
 #include "utils/event_emitter/event_emitter.h"
+#include "utils/latency/latency.h"
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <thread>
+#include <vector>
 
 namespace services
 {
+  // Owns the GUI loop on the calling thread and a services thread that
+  // calls each service's update() every tick_interval(). Between ticks the
+  // services thread sleeps until the earliest deadline or until a task is
+  // posted, and it records how long every update() takes.
+  //
+  // Without a window (headless mode) no SDL, ImGui or scene is set up, and
+  // run() just blocks the calling thread until shutdown().
   class main_loop
   {
   private:
   public:
-    main_loop();
-    ~main_loop();
+    explicit main_loop(bool with_window = true);
+    // Inline so that code using the service locator without a window
+    // (keyleport_bench) does not link the GUI through this file.
+    ~main_loop() = default;
 
     void init();
     void run();
     void cleanup();
+    // Makes run() return. Only stores an atomic flag, so it is safe from
+    // any thread and from a signal handler.
     void shutdown();
 
+    // Run 'task' on the services thread as soon as possible; any thread.
+    void post(std::function<void()> task);
+
   private:
-    bool running_ = false;
+    using clock = std::chrono::steady_clock;
+
+    // An update() slower than this is logged
+    static constexpr std::chrono::milliseconds kSlowUpdate{5};
+    // Update duration statistics are logged this often
+    static constexpr std::chrono::seconds kStatsInterval{10};
+    // How often a headless run() checks for shutdown()
+    static constexpr std::chrono::milliseconds kHeadlessPollInterval{50};
+
+    // Services thread only
+    struct service_slot
+    {
+      std::shared_ptr<service_lifecycle_listener> service;
+      clock::time_point next_due;
+      std::unique_ptr<utils::latency::histogram> durations;
+    };
+
+    const bool with_window_;
+    // Cleared by shutdown(), which may come before run()
+    std::atomic<bool> running_{true};
     std::thread services_thread_;
     std::atomic<bool> services_running_{false};
+
+    std::mutex tasks_m_;
+    std::condition_variable tasks_cv_;
+    std::vector<std::function<void()>> tasks_; // guarded by tasks_m_
+
+    std::vector<service_slot> slots_;
+    clock::time_point next_stats_{};
+
+    void services_loop();
+    // Match slots_ to the registered services; new ones are due at once.
+    void sync_slots(clock::time_point now);
+    void run_tasks();
+    // Update every due service; returns the earliest next deadline.
+    clock::time_point run_due_services(clock::time_point now);
+    void wait_until(clock::time_point deadline);
+    void log_stats();
   };
 } // namespace services
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <chrono>
+
 namespace services
 {
   class service_lifecycle_listener
@@ -10,5 +12,15 @@ namespace services
     virtual void init() = 0;
     virtual void update() = 0;
     virtual void cleanup() = 0;
+
+    // How often main_loop calls update() on the services thread. Work that
+    // cannot wait for the next tick should be handed to main_loop::post().
+    virtual std::chrono::milliseconds tick_interval() const
+    {
+      return std::chrono::milliseconds(1);
+    }
+
+    // Label for main_loop's per-service update statistics.
+    virtual const char* service_name() const { return "service"; }
   };
-} // namespace services
\ No newline at end of file
+} // namespace services
@@ -0,0 +1,49 @@
+// Little-endian load/store helpers for fixed-layout wire formats
+#pragma once
+
+#include <cstdint>
+
+namespace utils
+{
+  namespace byte_order
+  {
+    inline void put_u16(uint8_t* out, uint16_t v)
+    {
+      out[0] = static_cast<uint8_t>(v);
+      out[1] = static_cast<uint8_t>(v >> 8);
+    }
+
+    inline void put_u32(uint8_t* out, uint32_t v)
+    {
+      out[0] = static_cast<uint8_t>(v);
+      out[1] = static_cast<uint8_t>(v >> 8);
+      out[2] = static_cast<uint8_t>(v >> 16);
+      out[3] = static_cast<uint8_t>(v >> 24);
+    }
+
+    inline void put_u64(uint8_t* out, uint64_t v)
+    {
+      put_u32(out, static_cast<uint32_t>(v));
+      put_u32(out + 4, static_cast<uint32_t>(v >> 32));
+    }
+
+    inline uint16_t get_u16(const uint8_t* in)
+    {
+      return static_cast<uint16_t>(in[0] | (in[1] << 8));
+    }
+
+    inline uint32_t get_u32(const uint8_t* in)
+    {
+      return static_cast<uint32_t>(in[0]) |
+             (static_cast<uint32_t>(in[1]) << 8) |
+             (static_cast<uint32_t>(in[2]) << 16) |
+             (static_cast<uint32_t>(in[3]) << 24);
+    }
+
+    inline uint64_t get_u64(const uint8_t* in)
+    {
+      return static_cast<uint64_t>(get_u32(in)) |
+             (static_cast<uint64_t>(get_u32(in + 4)) << 32);
+    }
+  } // namespace byte_order
+} // namespace utils
@@ -15,11 +15,12 @@ namespace cli
   {
     Options opt{};
 #ifdef _WIN32
-    // On Windows, default to receiver on port 8080 when no args are provided
+    // On Windows, default to receiver on the default port when no args are
+    // provided
     if (argc <= 1)
     {
       opt.mode = "receiver";
-      opt.port = 8080;
+      opt.port = kDefaultPort;
       return opt;
     }
 #endif
@@ -46,6 +47,27 @@ namespace cli
           return opt;
         }
       }
+      else if ((arg == "--transport" || arg == "-t") && i + 1 < argc)
+      {
+        opt.transport = argv[++i];
+      }
+      else if (arg == "--key-copies" && i + 1 < argc)
+      {
+        try
+        {
+          opt.key_copies = std::stoi(argv[++i]);
+        }
+        catch (...)
+        {
+          set_error(opt, "Invalid --key-copies value");
+          return opt;
+        }
+        if (opt.key_copies < 0)
+        {
+          set_error(opt, "--key-copies must not be negative");
+          return opt;
+        }
+      }
       else if (arg == "--help" || arg == "-h")
       {
         opt.help = true;
@@ -63,9 +85,13 @@ namespace cli
       {
         set_error(opt, "--mode must be 'sender' or 'receiver'");
       }
+      else if (opt.mode == "sender" && opt.ip.empty())
+      {
+        set_error(opt, "--ip is required in sender mode");
+      }
       if (opt.port <= 0)
       {
-        opt.port = 8080; // default
+        opt.port = kDefaultPort;
       }
     }
     return opt;
@@ -75,6 +101,7 @@ namespace cli
   {
     std::cout << "Usage: " << program_name
               << " --mode <sender|receiver> [--ip <addr>] [--port <port>]"
+                 " [--transport <enet|raw_udp>] [--key-copies <n>]"
               << std::endl;
   }
 
@@ -5,14 +5,21 @@
 namespace cli
 {
 
+  // communication_service's port, so headless and GUI peers meet
+  constexpr int kDefaultPort = 8801;
+
   struct Options
   {
     std::string mode;  // "sender" or "receiver"
     std::string ip;    // required if mode == sender
-    int port = 0;      // defaulted to 8080 in parse() if <= 0
+    int port = 0;      // defaulted to kDefaultPort in parse() if <= 0
     bool help = false; // --help or -h
     bool valid = true; // false if parsing error
     std::string error; // optional error message
+    // p2p::transport_kind_name() of the transport to use
+    std::string transport = "enet";
+    // Unreliable copies sent ahead of each reliable key event (sender)
+    int key_copies = 0;
   };
 
   Options parse(int argc, char* argv[]);
@@ -4,6 +4,7 @@
 
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <vector>
 
@@ -21,6 +22,11 @@ namespace utils
     using type = std::function<void()>;
   };
 
+  // Subscribers are kept in an immutable list that subscribe() and
+  // unsubscribe() replace (copy-on-write). emit() only takes a reference to
+  // the current list, so emitting allocates nothing and copies no
+  // std::function; callbacks run without the lock held, so they may
+  // subscribe or unsubscribe freely.
   template <typename EventT> class event_emitter
   {
   public:
@@ -31,7 +37,9 @@ namespace utils
     {
       std::lock_guard<std::mutex> lock(mutex_);
       const auto id = ++next_id_;
-      subscribers_.push_back(subscription_entry{id, std::move(cb)});
+      auto next = copy_subscribers();
+      next->push_back(subscription_entry{id, std::move(cb)});
+      subscribers_ = std::move(next);
       return id;
     }
     // Emit for non-void payload
@@ -39,21 +47,16 @@ namespace utils
               typename std::enable_if<!std::is_void<T>::value, int>::type = 0>
     void emit(const T& ev)
     {
-      // copy under lock, invoke without lock to avoid deadlocks
-      std::vector<callback_t> snapshot;
+      const auto subscribers = current_subscribers();
+      if (!subscribers)
       {
-        std::lock_guard<std::mutex> lock(mutex_);
-        snapshot.reserve(subscribers_.size());
-        for (const auto& s : subscribers_)
-        {
-          snapshot.push_back(s.callback);
-        }
+        return;
       }
-      for (auto& cb : snapshot)
+      for (const auto& s : *subscribers)
       {
-        if (cb)
+        if (s.callback)
         {
-          cb(ev);
+          s.callback(ev);
         }
       }
     }
@@ -63,32 +66,33 @@ namespace utils
               typename std::enable_if<std::is_void<T>::value, int>::type = 0>
     void emit()
     {
-      // copy under lock, invoke without lock to avoid deadlocks
-      std::vector<callback_t> snapshot;
+      const auto subscribers = current_subscribers();
+      if (!subscribers)
       {
-        std::lock_guard<std::mutex> lock(mutex_);
-        snapshot.reserve(subscribers_.size());
-        for (const auto& s : subscribers_)
-        {
-          snapshot.push_back(s.callback);
-        }
+        return;
       }
-      for (auto& cb : snapshot)
+      for (const auto& s : *subscribers)
       {
-        if (cb)
+        if (s.callback)
         {
-          cb();
+          s.callback();
         }
       }
     }
     void unsubscribe(subscription_id id)
     {
       std::lock_guard<std::mutex> lock(mutex_);
-      for (auto it = subscribers_.begin(); it != subscribers_.end(); ++it)
+      if (!subscribers_)
+      {
+        return;
+      }
+      auto next = copy_subscribers();
+      for (auto it = next->begin(); it != next->end(); ++it)
       {
         if (it->id == id)
         {
-          subscribers_.erase(it);
+          next->erase(it);
+          subscribers_ = std::move(next);
           break;
         }
       }
@@ -96,7 +100,7 @@ namespace utils
     void clear_subscribers()
     {
       std::lock_guard<std::mutex> lock(mutex_);
-      subscribers_.clear();
+      subscribers_.reset();
     }
 
   private:
@@ -105,9 +109,24 @@ namespace utils
       subscription_id id{0};
       callback_t callback;
     };
+    using subscriber_list = std::vector<subscription_entry>;
+
+    // Caller holds mutex_
+    std::shared_ptr<subscriber_list> copy_subscribers() const
+    {
+      return subscribers_ ? std::make_shared<subscriber_list>(*subscribers_)
+                          : std::make_shared<subscriber_list>();
+    }
+
+    std::shared_ptr<const subscriber_list> current_subscribers() const
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      return subscribers_;
+    }
 
-    std::mutex mutex_;
-    std::vector<subscription_entry> subscribers_;
+    mutable std::mutex mutex_;
+    // Never modified once published; null when there are no subscribers
+    std::shared_ptr<const subscriber_list> subscribers_;
     subscription_id next_id_{0};
   };
 
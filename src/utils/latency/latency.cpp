@@ -0,0 +1,208 @@
+#include "latency.h"
+
+#include <iomanip>
+
+namespace utils
+{
+  namespace latency
+  {
+    namespace
+    {
+      constexpr size_t kStageCount = static_cast<size_t>(stage::count);
+
+      std::array<histogram, kStageCount>& histograms()
+      {
+        static std::array<histogram, kStageCount> all;
+        return all;
+      }
+
+      size_t floor_log2(uint64_t v)
+      {
+        size_t r = 0;
+        for (size_t shift = 32; shift > 0; shift /= 2)
+        {
+          if (v >> shift)
+          {
+            v >>= shift;
+            r += shift;
+          }
+        }
+        return r;
+      }
+    } // namespace
+
+    const char* stage_name(stage s)
+    {
+      switch (s)
+      {
+      case stage::capture_to_enqueue:
+        return "capture_to_enqueue";
+      case stage::capture_to_send:
+        return "capture_to_send";
+      case stage::receive_to_decode:
+        return "receive_to_decode";
+      case stage::receive_to_inject:
+        return "receive_to_inject";
+      default:
+        return "unknown";
+      }
+    }
+
+    size_t histogram::bucket_of(uint64_t v)
+    {
+      if (v < kSubBuckets)
+      {
+        return static_cast<size_t>(v);
+      }
+      size_t exponent = floor_log2(v);
+      if (exponent > kMaxExponent)
+      {
+        return kBuckets - 1;
+      }
+      const size_t shift = exponent - kSubBucketBits;
+      const size_t sub = static_cast<size_t>(v >> shift) & (kSubBuckets - 1);
+      return kSubBuckets + shift * kSubBuckets + sub;
+    }
+
+    uint64_t histogram::bucket_midpoint(size_t index)
+    {
+      if (index < kSubBuckets)
+      {
+        return index;
+      }
+      const size_t shift = (index - kSubBuckets) / kSubBuckets;
+      const size_t sub = (index - kSubBuckets) % kSubBuckets;
+      const uint64_t low = static_cast<uint64_t>(kSubBuckets + sub) << shift;
+      return low + ((uint64_t{1} << shift) >> 1);
+    }
+
+    void histogram::record(uint64_t value_ns)
+    {
+      buckets_[bucket_of(value_ns)].fetch_add(1, std::memory_order_relaxed);
+      count_.fetch_add(1, std::memory_order_relaxed);
+      uint64_t prev = max_.load(std::memory_order_relaxed);
+      while (value_ns > prev &&
+             !max_.compare_exchange_weak(prev, value_ns,
+                                         std::memory_order_relaxed))
+      {
+      }
+    }
+
+    uint64_t histogram::percentile(double q) const
+    {
+      uint64_t total = 0;
+      std::array<uint64_t, kBuckets> counts;
+      for (size_t i = 0; i < kBuckets; ++i)
+      {
+        counts[i] = buckets_[i].load(std::memory_order_relaxed);
+        total += counts[i];
+      }
+      if (total == 0)
+      {
+        return 0;
+      }
+      q = q < 0.0 ? 0.0 : (q > 1.0 ? 1.0 : q);
+      // Rank of the sample at quantile q, 1-based
+      uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total));
+      rank = rank == 0 ? 1 : (rank > total ? total : rank);
+      uint64_t seen = 0;
+      for (size_t i = 0; i < kBuckets; ++i)
+      {
+        seen += counts[i];
+        if (seen >= rank)
+        {
+          return bucket_midpoint(i);
+        }
+      }
+      return bucket_midpoint(kBuckets - 1);
+    }
+
+    void histogram::reset()
+    {
+      for (auto& b : buckets_)
+      {
+        b.store(0, std::memory_order_relaxed);
+      }
+      count_.store(0, std::memory_order_relaxed);
+      max_.store(0, std::memory_order_relaxed);
+    }
+
+    void record_since(stage s, uint64_t start_ns)
+    {
+      if (start_ns == 0 || s >= stage::count)
+      {
+        return;
+      }
+      const uint64_t now = now_ns();
+      histograms()[static_cast<size_t>(s)].record(
+          now > start_ns ? now - start_ns : 0);
+    }
+
+    std::vector<stage_stats> snapshot()
+    {
+      std::vector<stage_stats> out;
+      for (size_t i = 0; i < kStageCount; ++i)
+      {
+        const histogram& h = histograms()[i];
+        if (h.count() == 0)
+        {
+          continue;
+        }
+        out.push_back(stage_stats{static_cast<stage>(i), h.count(),
+                                  h.percentile(0.50), h.percentile(0.99),
+                                  h.percentile(0.999), h.max()});
+      }
+      return out;
+    }
+
+    void reset()
+    {
+      for (auto& h : histograms())
+      {
+        h.reset();
+      }
+    }
+
+    void dump(std::ostream& os)
+    {
+      const auto us = [](uint64_t ns)
+      { return static_cast<double>(ns) / 1000.0; };
+      for (const auto& s : snapshot())
+      {
+        os << "[latency] " << stage_name(s.id) << " n=" << s.count
+           << std::fixed << std::setprecision(1) << " p50=" << us(s.p50_ns)
+           << "us p99=" << us(s.p99_ns) << "us p999=" << us(s.p999_ns)
+           << "us max=" << us(s.max_ns) << "us" << std::defaultfloat
+           << std::endl;
+      }
+    }
+
+    bool dump_due(std::chrono::milliseconds interval)
+    {
+      static std::atomic<uint64_t> last_dump_ns{0};
+      const uint64_t now = now_ns();
+      uint64_t last = last_dump_ns.load(std::memory_order_relaxed);
+      if (last == 0)
+      {
+        // First call only starts the period
+        last_dump_ns.compare_exchange_strong(last, now,
+                                             std::memory_order_relaxed);
+        return false;
+      }
+      const auto interval_ns = static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(interval)
+              .count());
+      return now - last >= interval_ns &&
+             last_dump_ns.compare_exchange_strong(last, now,
+                                                  std::memory_order_relaxed);
+    }
+
+    void dump_if_due(std::ostream& os, std::chrono::milliseconds interval)
+    {
+      if (dump_due(interval))
+      {
+        dump(os);
+      }
+    }
+  } // namespace latency
+} // namespace utils
@@ -0,0 +1,104 @@
+// Per-stage input latency histograms.
+//
+// Every stage an input event passes through records "now - reference" into a
+// process-wide histogram. References are steady_clock nanoseconds: the
+// capture time on the sender (see InputEvent::timestamp_ns) and the datagram
+// receipt time on the receiver. Sender and receiver clocks are unrelated, so
+// each side only measures its own hops.
+//
+// Recording is lock-free (a few relaxed atomic adds) and safe from any
+// thread. Buckets are log-linear in the HDR style: exact below 16 ns, then 16
+// sub-buckets per power of two (within ~6%), up to ~18 minutes.
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace utils
+{
+  namespace latency
+  {
+    enum class stage : uint8_t
+    {
+      // Sender
+      capture_to_enqueue, // SDL timestamp -> SenderFlow::push_event
+      capture_to_send,    // SDL timestamp -> handed to ENet in udp_client
+      // Receiver
+      receive_to_decode, // udp_server receipt -> typed_package decoded
+      receive_to_inject, // udp_server receipt -> Emitter::emit returned
+      count
+    };
+
+    const char* stage_name(stage s);
+
+    // steady_clock::now() in nanoseconds; the clock all stamps use.
+    inline uint64_t now_ns()
+    {
+      return static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::steady_clock::now().time_since_epoch())
+              .count());
+    }
+
+    class histogram
+    {
+    public:
+      static constexpr size_t kSubBucketBits = 4;
+      static constexpr size_t kSubBuckets = size_t{1} << kSubBucketBits;
+      static constexpr size_t kMaxExponent = 40; // 2^40 ns ~ 18 min
+      static constexpr size_t kBuckets =
+          kSubBuckets + (kMaxExponent - kSubBucketBits + 1) * kSubBuckets;
+
+      void record(uint64_t value_ns);
+
+      // Value at quantile q (0..1), as the midpoint of its bucket; 0 when
+      // empty. Reads are not atomic as a whole, which is fine for stats.
+      uint64_t percentile(double q) const;
+      uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+      uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+      void reset();
+
+    private:
+      std::array<std::atomic<uint64_t>, kBuckets> buckets_{};
+      std::atomic<uint64_t> count_{0};
+      std::atomic<uint64_t> max_{0};
+
+      static size_t bucket_of(uint64_t v);
+      static uint64_t bucket_midpoint(size_t index);
+    };
+
+    struct stage_stats
+    {
+      stage id;
+      uint64_t count;
+      uint64_t p50_ns;
+      uint64_t p99_ns;
+      uint64_t p999_ns;
+      uint64_t max_ns;
+    };
+
+    // Record a sample for 's'. 'start_ns' is a now_ns() reference; 0 means
+    // "unknown" and is ignored.
+    void record_since(stage s, uint64_t start_ns);
+
+    // Stages with at least one sample.
+    std::vector<stage_stats> snapshot();
+    void reset();
+
+    // One line per stage, "[latency] <stage> n=.. p50=..us p99=..us ...".
+    void dump(std::ostream& os);
+    // True at most once per 'interval', when a periodic loop should dump().
+    // The first call only starts the period.
+    bool dump_due(
+        std::chrono::milliseconds interval = std::chrono::seconds(10));
+    // dump() at most once per 'interval'; call from any periodic loop.
+    void dump_if_due(std::ostream& os, std::chrono::milliseconds interval =
+                                           std::chrono::seconds(10));
+  } // namespace latency
+} // namespace utils
@@ -0,0 +1,246 @@
+#include "log.h"
+
+#include "utils/mpsc_queue/mpsc_queue.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace utils
+{
+  namespace log
+  {
+    namespace
+    {
+      constexpr size_t kRingCapacity = 1024;
+      // Writer wakeup when nobody signals, e.g. after a dropped wake race
+      constexpr std::chrono::milliseconds kIdleWait{100};
+
+      std::atomic<uint8_t> g_level{KEYLEPORT_LOG_LEVEL};
+
+      uint64_t now_ms()
+      {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now().time_since_epoch())
+                .count());
+      }
+
+      struct record
+      {
+        level lvl = level::info;
+        const char* tag = nullptr;
+        uint32_t suppressed = 0;
+        std::string text;
+      };
+
+      // Single background writer draining the ring to the console.
+      class writer
+      {
+      public:
+        writer() : thread_(&writer::run, this) {}
+
+        ~writer()
+        {
+          running_.store(false, std::memory_order_relaxed);
+          notify();
+          thread_.join();
+        }
+
+        void submit(record&& r)
+        {
+          if (!ring_.try_push(std::move(r)))
+          {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+          }
+          submitted_.fetch_add(1, std::memory_order_release);
+          // Pairs with the fence in run(): either the writer sees the record
+          // when it re-checks, or we see it parked and notify.
+          std::atomic_thread_fence(std::memory_order_seq_cst);
+          if (parked_.load(std::memory_order_relaxed))
+          {
+            notify();
+          }
+        }
+
+        void flush()
+        {
+          const uint64_t target = submitted_.load(std::memory_order_acquire);
+          std::unique_lock<std::mutex> lock(m_);
+          notify_locked();
+          written_cv_.wait(lock, [&]
+                           { return written_ >= target || !running_; });
+        }
+
+      private:
+        mpsc_queue<record, kRingCapacity> ring_;
+        std::atomic<uint64_t> submitted_{0};
+        std::atomic<uint64_t> dropped_{0};
+        std::atomic<bool> running_{true};
+        std::atomic<bool> parked_{false};
+
+        std::mutex m_;
+        std::condition_variable wake_cv_;
+        std::condition_variable written_cv_;
+        uint64_t written_{0}; // guarded by m_
+        bool wake_{false};    // guarded by m_
+
+        std::thread thread_;
+
+        void notify()
+        {
+          std::lock_guard<std::mutex> lock(m_);
+          notify_locked();
+        }
+
+        void notify_locked()
+        {
+          wake_ = true;
+          wake_cv_.notify_one();
+        }
+
+        void run()
+        {
+          for (;;)
+          {
+            const uint64_t n = drain();
+            {
+              std::lock_guard<std::mutex> lock(m_);
+              written_ += n;
+            }
+            written_cv_.notify_all();
+            if (!running_.load(std::memory_order_relaxed) && ring_.empty())
+            {
+              return;
+            }
+
+            std::unique_lock<std::mutex> lock(m_);
+            parked_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (ring_.empty() && !wake_)
+            {
+              wake_cv_.wait_for(lock, kIdleWait, [this] { return wake_; });
+            }
+            wake_ = false;
+            parked_.store(false, std::memory_order_relaxed);
+          }
+        }
+
+        uint64_t drain()
+        {
+          uint64_t n = 0;
+          bool wrote_out = false;
+          bool wrote_err = false;
+          record r;
+          while (ring_.try_pop(r))
+          {
+            const bool to_err = r.lvl >= level::warn;
+            std::ostream& os = to_err ? std::cerr : std::cout;
+            if (r.tag && *r.tag)
+            {
+              os << '[' << r.tag << "] ";
+            }
+            os << r.text;
+            if (r.suppressed > 0)
+            {
+              os << " (" << r.suppressed << " similar suppressed)";
+            }
+            os << '\n';
+            (to_err ? wrote_err : wrote_out) = true;
+            ++n;
+          }
+          const uint64_t dropped = dropped_.exchange(0);
+          if (dropped > 0)
+          {
+            std::cerr << "[log] Dropped " << dropped
+                      << " line(s), ring full\n";
+            wrote_err = true;
+          }
+          if (wrote_out)
+          {
+            std::cout.flush();
+          }
+          if (wrote_err)
+          {
+            std::cerr.flush();
+          }
+          return n;
+        }
+      };
+
+      writer& instance()
+      {
+        static writer w;
+        return w;
+      }
+
+      std::ostringstream& thread_stream()
+      {
+        thread_local std::ostringstream os;
+        os.str(std::string());
+        os.clear();
+        return os;
+      }
+    } // namespace
+
+    void set_level(level min_level)
+    {
+      g_level.store(static_cast<uint8_t>(min_level), std::memory_order_relaxed);
+    }
+
+    level get_level()
+    {
+      return static_cast<level>(g_level.load(std::memory_order_relaxed));
+    }
+
+    bool enabled(level l)
+    {
+      return static_cast<uint8_t>(l) >=
+             g_level.load(std::memory_order_relaxed);
+    }
+
+    void flush()
+    {
+      instance().flush();
+    }
+
+    bool rate_limiter::allow(uint32_t& suppressed)
+    {
+      const uint64_t now = now_ms();
+      uint64_t start = window_start_ms_.load(std::memory_order_relaxed);
+      if (now - start >= kWindowMs &&
+          window_start_ms_.compare_exchange_strong(start, now,
+                                                   std::memory_order_relaxed))
+      {
+        count_.store(0, std::memory_order_relaxed);
+      }
+      if (count_.fetch_add(1, std::memory_order_relaxed) >= kBurst)
+      {
+        suppressed_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+      suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+      return true;
+    }
+
+    line::line(level l, const char* tag, uint32_t suppressed)
+        : level_(l), tag_(tag), suppressed_(suppressed),
+          stream_(thread_stream())
+    {
+    }
+
+    line::~line()
+    {
+      record r;
+      r.lvl = level_;
+      r.tag = tag_;
+      r.suppressed = suppressed_;
+      r.text = stream_.str();
+      instance().submit(std::move(r));
+    }
+  } // namespace log
+} // namespace utils
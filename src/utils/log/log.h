@@ -0,0 +1,145 @@
+// Leveled, rate-limited logging that keeps console I/O off the caller.
+//
+//   KP_LOG_INFO("udp_client", "Sent " << n << " packet(s)");
+//
+// prints "[udp_client] Sent 3 packet(s)". The message is formatted on the
+// calling thread into a thread-local buffer and handed to a background
+// writer through a bounded lock-free ring; the caller never blocks on the
+// console. When the ring is full the line is dropped and counted, and the
+// writer reports the count later.
+//
+// Statements below KEYLEPORT_LOG_LEVEL (a compile definition, info by
+// default) compile to nothing, arguments included, so per-packet debug and
+// trace lines cost nothing in normal builds. The rest are further filtered
+// by the runtime level (set_level). Each call site lets kBurst lines through
+// per second; the number it suppressed is appended to the next line it
+// lets through.
+//
+// Warnings and errors go to stderr, everything else to stdout.
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <sstream>
+
+#define KEYLEPORT_LOG_LEVEL_TRACE 0
+#define KEYLEPORT_LOG_LEVEL_DEBUG 1
+#define KEYLEPORT_LOG_LEVEL_INFO 2
+#define KEYLEPORT_LOG_LEVEL_WARN 3
+#define KEYLEPORT_LOG_LEVEL_ERROR 4
+#define KEYLEPORT_LOG_LEVEL_OFF 5
+
+#ifndef KEYLEPORT_LOG_LEVEL
+#define KEYLEPORT_LOG_LEVEL KEYLEPORT_LOG_LEVEL_INFO
+#endif
+
+namespace utils
+{
+  namespace log
+  {
+    enum class level : uint8_t
+    {
+      trace = KEYLEPORT_LOG_LEVEL_TRACE,
+      debug = KEYLEPORT_LOG_LEVEL_DEBUG,
+      info = KEYLEPORT_LOG_LEVEL_INFO,
+      warn = KEYLEPORT_LOG_LEVEL_WARN,
+      error = KEYLEPORT_LOG_LEVEL_ERROR,
+      off = KEYLEPORT_LOG_LEVEL_OFF,
+    };
+
+    // Runtime threshold; starts at the compiled-in level.
+    void set_level(level min_level);
+    level get_level();
+    bool enabled(level l);
+
+    // Block until everything logged so far has been written.
+    void flush();
+
+    // Per-call-site budget of kBurst lines per kWindowMs.
+    class rate_limiter
+    {
+    public:
+      static constexpr uint32_t kBurst = 20;
+      static constexpr uint64_t kWindowMs = 1000;
+
+      // True if the line may be written; 'suppressed' then holds how many
+      // lines this site dropped since the last one that went through.
+      bool allow(uint32_t& suppressed);
+
+    private:
+      std::atomic<uint64_t> window_start_ms_{0};
+      std::atomic<uint32_t> count_{0};
+      std::atomic<uint32_t> suppressed_{0};
+    };
+
+    // One log statement; submits on destruction. Use the macros. 'tag'
+    // must be a string literal: the writer reads it later.
+    class line
+    {
+    public:
+      line(level l, const char* tag, uint32_t suppressed);
+      ~line();
+
+      line(const line&) = delete;
+      line& operator=(const line&) = delete;
+
+      std::ostringstream& stream() { return stream_; }
+
+    private:
+      level level_;
+      const char* tag_;
+      uint32_t suppressed_;
+      std::ostringstream& stream_;
+    };
+  } // namespace log
+} // namespace utils
+
+#define KP_LOG_AT(lvl, tag, expr)                                              \
+  do                                                                           \
+  {                                                                            \
+    if (::utils::log::enabled(lvl))                                            \
+    {                                                                          \
+      static ::utils::log::rate_limiter kp_log_limiter;                        \
+      uint32_t kp_log_suppressed = 0;                                          \
+      if (kp_log_limiter.allow(kp_log_suppressed))                             \
+      {                                                                        \
+        ::utils::log::line kp_log_line(lvl, tag, kp_log_suppressed);           \
+        kp_log_line.stream() << expr;                                          \
+      }                                                                        \
+    }                                                                          \
+  } while (0)
+
+#define KP_LOG_DISABLED(tag, expr)                                             \
+  do                                                                           \
+  {                                                                            \
+  } while (0)
+
+#if KEYLEPORT_LOG_LEVEL <= KEYLEPORT_LOG_LEVEL_TRACE
+#define KP_LOG_TRACE(tag, expr) KP_LOG_AT(::utils::log::level::trace, tag, expr)
+#else
+#define KP_LOG_TRACE(tag, expr) KP_LOG_DISABLED(tag, expr)
+#endif
+
+#if KEYLEPORT_LOG_LEVEL <= KEYLEPORT_LOG_LEVEL_DEBUG
+#define KP_LOG_DEBUG(tag, expr) KP_LOG_AT(::utils::log::level::debug, tag, expr)
+#else
+#define KP_LOG_DEBUG(tag, expr) KP_LOG_DISABLED(tag, expr)
+#endif
+
+#if KEYLEPORT_LOG_LEVEL <= KEYLEPORT_LOG_LEVEL_INFO
+#define KP_LOG_INFO(tag, expr) KP_LOG_AT(::utils::log::level::info, tag, expr)
+#else
+#define KP_LOG_INFO(tag, expr) KP_LOG_DISABLED(tag, expr)
+#endif
+
+#if KEYLEPORT_LOG_LEVEL <= KEYLEPORT_LOG_LEVEL_WARN
+#define KP_LOG_WARN(tag, expr) KP_LOG_AT(::utils::log::level::warn, tag, expr)
+#else
+#define KP_LOG_WARN(tag, expr) KP_LOG_DISABLED(tag, expr)
+#endif
+
+#if KEYLEPORT_LOG_LEVEL <= KEYLEPORT_LOG_LEVEL_ERROR
+#define KP_LOG_ERROR(tag, expr) KP_LOG_AT(::utils::log::level::error, tag, expr)
+#else
+#define KP_LOG_ERROR(tag, expr) KP_LOG_DISABLED(tag, expr)
+#endif
@@ -0,0 +1,106 @@
+// Bounded lock-free multi-producer single-consumer queue.
+//
+// A ring of cells tagged with sequence numbers (D. Vyukov's bounded queue,
+// restricted to one consumer). Producers claim a slot with one CAS on the
+// head and publish it with a release store; the consumer never writes shared
+// state other than the cell sequence it just emptied. Nothing allocates
+// after construction, so pushing from an input callback is safe.
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace utils
+{
+  template <typename T, size_t Capacity> class mpsc_queue
+  {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "mpsc_queue: capacity must be a power of two");
+
+  public:
+    mpsc_queue()
+    {
+      for (size_t i = 0; i < Capacity; ++i)
+      {
+        cells_[i].seq.store(i, std::memory_order_relaxed);
+      }
+    }
+
+    mpsc_queue(const mpsc_queue&) = delete;
+    mpsc_queue& operator=(const mpsc_queue&) = delete;
+
+    // Any thread. Returns false when the queue is full.
+    bool try_push(const T& value) { return push_impl(value); }
+    bool try_push(T&& value) { return push_impl(std::move(value)); }
+
+    // Consumer thread only. Returns false when nothing is ready.
+    bool try_pop(T& out)
+    {
+      cell& c = cells_[tail_ & kMask];
+      if (c.seq.load(std::memory_order_acquire) != tail_ + 1)
+      {
+        return false;
+      }
+      out = std::move(c.value);
+      c.seq.store(tail_ + Capacity, std::memory_order_release);
+      ++tail_;
+      return true;
+    }
+
+    // Consumer thread only.
+    bool empty() const
+    {
+      return cells_[tail_ & kMask].seq.load(std::memory_order_acquire) !=
+             tail_ + 1;
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+  private:
+    static constexpr size_t kMask = Capacity - 1;
+    static constexpr size_t kCacheLine = 64;
+
+    template <typename U> bool push_impl(U&& value)
+    {
+      size_t pos = head_.load(std::memory_order_relaxed);
+      for (;;)
+      {
+        cell& c = cells_[pos & kMask];
+        const size_t seq = c.seq.load(std::memory_order_acquire);
+        const auto dif =
+            static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if (dif == 0)
+        {
+          if (head_.compare_exchange_weak(pos, pos + 1,
+                                          std::memory_order_relaxed))
+          {
+            c.value = std::forward<U>(value);
+            c.seq.store(pos + 1, std::memory_order_release);
+            return true;
+          }
+        }
+        else if (dif < 0)
+        {
+          return false;
+        }
+        else
+        {
+          pos = head_.load(std::memory_order_relaxed);
+        }
+      }
+    }
+
+    struct cell
+    {
+      std::atomic<size_t> seq{0};
+      T value{};
+    };
+
+    alignas(kCacheLine) std::atomic<size_t> head_{0};
+    alignas(kCacheLine) size_t tail_{0};
+    alignas(kCacheLine) std::array<cell, Capacity> cells_;
+  };
+} // namespace utils
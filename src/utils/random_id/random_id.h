@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <random>
 #include <string>
 
@@ -21,4 +22,18 @@ std::string get_random_id(std::size_t length = 16)
   }
 
   return random_id;
-}
\ No newline at end of file
+}
+
+// Non-zero 64-bit id, seeded from the OS entropy source so that machines
+// started at the same second do not collide.
+inline uint64_t get_random_device_id()
+{
+  std::random_device rd;
+  std::mt19937_64 rng{(static_cast<uint64_t>(rd()) << 32) ^ rd()};
+  uint64_t id = 0;
+  while (id == 0)
+  {
+    id = rng();
+  }
+  return id;
+}
@@ -0,0 +1,422 @@
+// Field-list driven serialization.
+//
+// A struct opts in by declaring its fields once:
+//
+//   static constexpr auto fields()
+//   {
+//     using utils::serialization::field;
+//     return std::make_tuple(field(1, "device_id", &peer::device_id),
+//                            field(2, "state", &peer::state));
+//   }
+//
+// and gets both a binary and a JSON codec from that single description.
+//
+// Binary format: a sequence of tagged fields, key = varint(id << 3 | wire),
+// where wire is 0 for varint values (integers, enums, bools; signed values
+// zig-zag mapped) and 2 for length-prefixed bytes (strings). Decoders skip
+// ids they do not know and leave absent fields at their defaults, so fields
+// can be added without breaking older peers. Never reuse or renumber ids.
+//
+// JSON format: an object keyed by field name; missing or mistyped keys keep
+// their defaults.
+#pragma once
+
+#include "utils/serialization/varint.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace utils
+{
+  namespace serialization
+  {
+    template <typename T, typename M> struct field_t
+    {
+      using owner_type = T;
+      using member_type = M;
+
+      uint32_t id;
+      const char* name;
+      M T::*member;
+    };
+
+    template <typename T, typename M>
+    constexpr field_t<T, M> field(uint32_t id, const char* name, M T::*member)
+    {
+      return field_t<T, M>{id, name, member};
+    }
+
+    namespace detail
+    {
+      enum class wire_type : uint8_t
+      {
+        varint = 0,
+        bytes = 2,
+      };
+
+      template <typename M> constexpr bool is_bytes_v =
+          std::is_same<M, std::string>::value;
+
+      template <typename M> constexpr bool is_varint_v =
+          std::is_integral<M>::value || std::is_enum<M>::value;
+
+      template <typename M> constexpr wire_type wire_type_of()
+      {
+        static_assert(is_bytes_v<M> || is_varint_v<M>,
+                      "serialization: unsupported field type");
+        return is_bytes_v<M> ? wire_type::bytes : wire_type::varint;
+      }
+
+      template <typename M> uint64_t to_varint(const M& v)
+      {
+        if constexpr (std::is_enum<M>::value)
+        {
+          return to_varint(static_cast<std::underlying_type_t<M>>(v));
+        }
+        else if constexpr (std::is_same<M, bool>::value)
+        {
+          return v ? 1 : 0;
+        }
+        else if constexpr (std::is_signed<M>::value)
+        {
+          return zigzag(static_cast<int64_t>(v));
+        }
+        else
+        {
+          return static_cast<uint64_t>(v);
+        }
+      }
+
+      // Returns false when the wire value does not fit M.
+      template <typename M> bool from_varint(uint64_t raw, M& out)
+      {
+        if constexpr (std::is_enum<M>::value)
+        {
+          std::underlying_type_t<M> u{};
+          if (!from_varint(raw, u))
+          {
+            return false;
+          }
+          out = static_cast<M>(u);
+          return true;
+        }
+        else if constexpr (std::is_same<M, bool>::value)
+        {
+          out = raw != 0;
+          return true;
+        }
+        else if constexpr (std::is_signed<M>::value)
+        {
+          const int64_t v = unzigzag(raw);
+          if (v < static_cast<int64_t>(std::numeric_limits<M>::min()) ||
+              v > static_cast<int64_t>(std::numeric_limits<M>::max()))
+          {
+            return false;
+          }
+          out = static_cast<M>(v);
+          return true;
+        }
+        else
+        {
+          if (raw > static_cast<uint64_t>(std::numeric_limits<M>::max()))
+          {
+            return false;
+          }
+          out = static_cast<M>(raw);
+          return true;
+        }
+      }
+
+      // Returns false when 'j' is not an integer or does not fit M.
+      template <typename M>
+      bool from_json_integer(const nlohmann::json& j, M& out)
+      {
+        if constexpr (std::is_enum<M>::value)
+        {
+          std::underlying_type_t<M> u{};
+          if (!from_json_integer(j, u))
+          {
+            return false;
+          }
+          out = static_cast<M>(u);
+          return true;
+        }
+        else if constexpr (std::is_signed<M>::value)
+        {
+          if (!j.is_number_integer())
+          {
+            return false;
+          }
+          return from_varint(zigzag(j.get<int64_t>()), out);
+        }
+        else
+        {
+          if (!j.is_number_unsigned())
+          {
+            return false;
+          }
+          return from_varint(j.get<uint64_t>(), out);
+        }
+      }
+
+      inline uint64_t make_key(uint32_t id, wire_type wire)
+      {
+        return (static_cast<uint64_t>(id) << 3) | static_cast<uint64_t>(wire);
+      }
+
+      template <typename Tuple, typename F>
+      void for_each_field(const Tuple& fields, F&& fn)
+      {
+        std::apply([&fn](const auto&... f) { (fn(f), ...); }, fields);
+      }
+
+      template <typename T> constexpr bool has_unique_ids()
+      {
+        constexpr auto ids = std::apply(
+            [](const auto&... f)
+            { return std::array<uint32_t, sizeof...(f)>{f.id...}; },
+            T::fields());
+        for (size_t i = 0; i < ids.size(); ++i)
+        {
+          if (ids[i] == 0)
+          {
+            return false;
+          }
+          for (size_t k = i + 1; k < ids.size(); ++k)
+          {
+            if (ids[i] == ids[k])
+            {
+              return false;
+            }
+          }
+        }
+        return true;
+      }
+
+      template <typename T> constexpr void check_fields()
+      {
+        static_assert(has_unique_ids<T>(),
+                      "serialization: field ids must be unique and non-zero");
+      }
+
+      template <typename M> size_t field_size(uint32_t id, const M& v)
+      {
+        const uint64_t key = make_key(id, wire_type_of<M>());
+        if constexpr (is_bytes_v<M>)
+        {
+          return varint_size(key) + varint_size(v.size()) + v.size();
+        }
+        else
+        {
+          return varint_size(key) + varint_size(to_varint(v));
+        }
+      }
+    } // namespace detail
+
+    // Exact number of bytes encode_binary() writes for 'obj'.
+    template <typename T> size_t binary_size(const T& obj)
+    {
+      detail::check_fields<T>();
+      size_t total = 0;
+      detail::for_each_field(
+          T::fields(), [&](const auto& f)
+          { total += detail::field_size(f.id, obj.*f.member); });
+      return total;
+    }
+
+    // Encode into a caller-provided buffer without allocating. Returns bytes
+    // written, or 0 if the buffer is too small.
+    template <typename T>
+    size_t encode_binary(const T& obj, uint8_t* out, size_t cap)
+    {
+      detail::check_fields<T>();
+      if (!out || cap < binary_size(obj))
+      {
+        return 0;
+      }
+      size_t pos = 0;
+      detail::for_each_field(
+          T::fields(),
+          [&](const auto& f)
+          {
+            using M = typename std::decay_t<decltype(f)>::member_type;
+            const M& v = obj.*f.member;
+            const uint64_t key =
+                detail::make_key(f.id, detail::wire_type_of<M>());
+            pos += put_varint(out + pos, key);
+            if constexpr (detail::is_bytes_v<M>)
+            {
+              pos += put_varint(out + pos, v.size());
+              v.copy(reinterpret_cast<char*>(out + pos), v.size());
+              pos += v.size();
+            }
+            else
+            {
+              pos += put_varint(out + pos, detail::to_varint(v));
+            }
+          });
+      return pos;
+    }
+
+    template <typename T> std::string encode_binary(const T& obj)
+    {
+      std::string out(binary_size(obj), '\0');
+      encode_binary(obj, reinterpret_cast<uint8_t*>(&out[0]), out.size());
+      return out;
+    }
+
+    // Decode tagged fields into 'obj'. Unknown ids are skipped; fields that
+    // are absent or carry an out-of-range value keep their current value.
+    // Returns false on malformed input.
+    template <typename T>
+    bool decode_binary(const uint8_t* data, size_t size, T& obj)
+    {
+      detail::check_fields<T>();
+      if (!data && size > 0)
+      {
+        return false;
+      }
+      size_t pos = 0;
+      while (pos < size)
+      {
+        uint64_t key = 0;
+        if (!get_varint(data, size, pos, key))
+        {
+          return false;
+        }
+        const uint64_t id = key >> 3;
+        const auto wire = static_cast<detail::wire_type>(key & 0x07);
+
+        uint64_t value = 0;
+        const uint8_t* bytes = nullptr;
+        if (wire == detail::wire_type::varint)
+        {
+          if (!get_varint(data, size, pos, value))
+          {
+            return false;
+          }
+        }
+        else if (wire == detail::wire_type::bytes)
+        {
+          if (!get_varint(data, size, pos, value) || value > size - pos)
+          {
+            return false;
+          }
+          bytes = data + pos;
+          pos += static_cast<size_t>(value);
+        }
+        else
+        {
+          return false; // unknown wire type: cannot skip safely
+        }
+
+        detail::for_each_field(
+            T::fields(),
+            [&](const auto& f)
+            {
+              using M = typename std::decay_t<decltype(f)>::member_type;
+              if (f.id != id || detail::wire_type_of<M>() != wire)
+              {
+                return;
+              }
+              if constexpr (detail::is_bytes_v<M>)
+              {
+                (obj.*f.member)
+                    .assign(reinterpret_cast<const char*>(bytes),
+                            static_cast<size_t>(value));
+              }
+              else
+              {
+                M v{};
+                if (detail::from_varint(value, v))
+                {
+                  obj.*f.member = v;
+                }
+              }
+            });
+      }
+      return true;
+    }
+
+    template <typename T> nlohmann::json to_json(const T& obj)
+    {
+      nlohmann::json j = nlohmann::json::object();
+      detail::for_each_field(
+          T::fields(),
+          [&](const auto& f)
+          {
+            using M = typename std::decay_t<decltype(f)>::member_type;
+            if constexpr (std::is_enum<M>::value)
+            {
+              j[f.name] = static_cast<std::underlying_type_t<M>>(obj.*f.member);
+            }
+            else
+            {
+              j[f.name] = obj.*f.member;
+            }
+          });
+      return j;
+    }
+
+    // Returns false if 'j' is not an object; otherwise copies every present,
+    // correctly typed key and leaves the rest untouched.
+    template <typename T> bool from_json(const nlohmann::json& j, T& obj)
+    {
+      if (!j.is_object())
+      {
+        return false;
+      }
+      detail::for_each_field(
+          T::fields(),
+          [&](const auto& f)
+          {
+            using M = typename std::decay_t<decltype(f)>::member_type;
+            auto it = j.find(f.name);
+            if (it == j.end())
+            {
+              return;
+            }
+            if constexpr (detail::is_bytes_v<M>)
+            {
+              if (it->is_string())
+              {
+                obj.*f.member = it->template get<std::string>();
+              }
+            }
+            else if constexpr (std::is_same<M, bool>::value)
+            {
+              if (it->is_boolean())
+              {
+                obj.*f.member = it->template get<bool>();
+              }
+            }
+            else
+            {
+              M v{};
+              if (detail::from_json_integer(*it, v))
+              {
+                obj.*f.member = v;
+              }
+            }
+          });
+      return true;
+    }
+
+    template <typename T> std::string encode_json(const T& obj)
+    {
+      return to_json(obj).dump();
+    }
+
+    template <typename T> bool decode_json(const std::string& s, T& obj)
+    {
+      return from_json(nlohmann::json::parse(s, nullptr, false), obj);
+    }
+  } // namespace serialization
+} // namespace utils
@@ -0,0 +1,66 @@
+// LEB128 varints and zig-zag mapping shared by the binary wire formats
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace utils
+{
+  namespace serialization
+  {
+    // Longest LEB128 encoding of a 64-bit value
+    constexpr size_t kMaxVarintSize = 10;
+
+    inline uint64_t zigzag(int64_t v)
+    {
+      return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+    }
+
+    inline int64_t unzigzag(uint64_t v)
+    {
+      return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+    }
+
+    inline size_t varint_size(uint64_t v)
+    {
+      size_t n = 1;
+      while (v >= 0x80)
+      {
+        v >>= 7;
+        ++n;
+      }
+      return n;
+    }
+
+    // Precondition: 'out' has room for varint_size(v) bytes.
+    inline size_t put_varint(uint8_t* out, uint64_t v)
+    {
+      size_t n = 0;
+      while (v >= 0x80)
+      {
+        out[n++] = static_cast<uint8_t>(v | 0x80);
+        v >>= 7;
+      }
+      out[n++] = static_cast<uint8_t>(v);
+      return n;
+    }
+
+    // Reads a varint at data[pos], advancing pos. Returns false on truncated
+    // or over-long input.
+    inline bool get_varint(const uint8_t* data, size_t size, size_t& pos,
+                           uint64_t& v)
+    {
+      v = 0;
+      for (unsigned shift = 0; shift < 64 && pos < size; shift += 7)
+      {
+        const uint8_t b = data[pos++];
+        v |= static_cast<uint64_t>(b & 0x7F) << shift;
+        if ((b & 0x80) == 0)
+        {
+          return true;
+        }
+      }
+      return false;
+    }
+  } // namespace serialization
+} // namespace utils
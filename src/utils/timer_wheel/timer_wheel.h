@@ -0,0 +1,258 @@
+// Small two-level hierarchical timer wheel for coalescing deadlines.
+//
+// Time is cut into ticks. Level 0 has one slot per tick for the next 64
+// ticks; level 1 has one slot per 64 ticks for the next 4096. Whenever level
+// 0 wraps, the matching level 1 slot is cascaded down. Timers further out
+// park in the level 1 slot that cascades last and are re-filed from there.
+// Timers are identified by small caller-chosen ids; rescheduling or
+// cancelling bumps a generation so stale slot entries are skipped lazily.
+//
+// Deadlines are rounded up to whole ticks, so a timer never fires early.
+// Not thread-safe: owned by a single worker.
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace utils
+{
+  class timer_wheel
+  {
+  public:
+    using clock = std::chrono::steady_clock;
+    using timer_id = uint32_t;
+
+    explicit timer_wheel(
+        clock::duration tick = std::chrono::milliseconds(1),
+        clock::time_point origin = clock::now())
+        : tick_(tick), origin_(origin)
+    {
+    }
+
+    // Arm (or re-arm) timer 'id' to fire at 'deadline'.
+    void schedule(timer_id id, clock::time_point deadline)
+    {
+      if (id >= timers_.size())
+      {
+        timers_.resize(id + 1);
+      }
+      timer& t = timers_[id];
+      if (!t.active)
+      {
+        ++active_;
+      }
+      t.active = true;
+      ++t.generation;
+      t.deadline_tick = to_tick(deadline);
+      file({id, t.generation});
+    }
+
+    void cancel(timer_id id)
+    {
+      if (id < timers_.size() && timers_[id].active)
+      {
+        timers_[id].active = false;
+        ++timers_[id].generation;
+        --active_;
+      }
+    }
+
+    bool scheduled(timer_id id) const
+    {
+      return id < timers_.size() && timers_[id].active;
+    }
+
+    bool empty() const { return active_ == 0; }
+
+    // Earliest instant at which advance() will fire something, or
+    // clock::time_point::max() when nothing is armed.
+    clock::time_point next_expiry() const
+    {
+      uint64_t best = std::numeric_limits<uint64_t>::max();
+      for (const auto& t : timers_)
+      {
+        if (t.active && t.deadline_tick < best)
+        {
+          best = t.deadline_tick;
+        }
+      }
+      if (best == std::numeric_limits<uint64_t>::max())
+      {
+        return clock::time_point::max();
+      }
+      return origin_ + tick_ * static_cast<clock::rep>(best);
+    }
+
+    // Fire every timer due at or before 'now', calling on_expired(id) for
+    // each. A callback may re-schedule its own timer.
+    template <typename F> void advance(clock::time_point now, F&& on_expired)
+    {
+      const uint64_t target = now < origin_ ? 0 : to_tick_floor(now);
+      if (active_ == 0)
+      {
+        current_ = std::max(current_, target);
+        return;
+      }
+      if (target > current_ + kSlots)
+      {
+        // Long gap (e.g. the worker was parked): re-file everything instead
+        // of stepping through every tick.
+        current_ = target;
+        refile_all();
+      }
+      fire_slot(due_, on_expired);
+      while (current_ < target)
+      {
+        ++current_;
+        if ((current_ & kMask) == 0)
+        {
+          cascade(level1_[(current_ >> kBits) & kMask]);
+        }
+        fire_slot(level0_[current_ & kMask], on_expired);
+        fire_slot(due_, on_expired);
+      }
+    }
+
+  private:
+    static constexpr uint64_t kBits = 6;
+    static constexpr uint64_t kSlots = uint64_t{1} << kBits;
+    static constexpr uint64_t kMask = kSlots - 1;
+
+    struct timer
+    {
+      uint64_t deadline_tick = 0;
+      uint32_t generation = 0;
+      bool active = false;
+    };
+
+    struct entry
+    {
+      timer_id id;
+      uint32_t generation;
+    };
+
+    using slot = std::vector<entry>;
+
+    clock::duration tick_;
+    clock::time_point origin_;
+    uint64_t current_ = 0;
+    size_t active_ = 0;
+    std::vector<timer> timers_;
+    std::array<slot, kSlots> level0_;
+    std::array<slot, kSlots> level1_;
+    slot due_; // deadline already reached when filed
+
+    uint64_t to_tick_floor(clock::time_point t) const
+    {
+      return static_cast<uint64_t>((t - origin_) / tick_);
+    }
+
+    uint64_t to_tick(clock::time_point t) const
+    {
+      if (t <= origin_)
+      {
+        return 0;
+      }
+      const auto since = t - origin_;
+      const uint64_t ticks = static_cast<uint64_t>(since / tick_);
+      return since % tick_ == clock::duration::zero() ? ticks : ticks + 1;
+    }
+
+    bool is_live(const entry& e) const
+    {
+      return e.id < timers_.size() && timers_[e.id].active &&
+             timers_[e.id].generation == e.generation;
+    }
+
+    void file(const entry& e)
+    {
+      const uint64_t deadline = timers_[e.id].deadline_tick;
+      if (deadline <= current_)
+      {
+        due_.push_back(e);
+      }
+      else if (deadline - current_ < kSlots)
+      {
+        level0_[deadline & kMask].push_back(e);
+      }
+      else if ((deadline >> kBits) - (current_ >> kBits) <= kSlots)
+      {
+        level1_[(deadline >> kBits) & kMask].push_back(e);
+      }
+      else
+      {
+        // Beyond the wheel: wait in the slot that cascades last.
+        level1_[(current_ >> kBits) & kMask].push_back(e);
+      }
+    }
+
+    void cascade(slot& s)
+    {
+      slot pending;
+      pending.swap(s);
+      for (const auto& e : pending)
+      {
+        if (is_live(e))
+        {
+          file(e);
+        }
+      }
+    }
+
+    void refile_all()
+    {
+      for (auto& s : level0_)
+      {
+        s.clear();
+      }
+      for (auto& s : level1_)
+      {
+        s.clear();
+      }
+      due_.clear();
+      for (size_t id = 0; id < timers_.size(); ++id)
+      {
+        if (timers_[id].active)
+        {
+          file({static_cast<timer_id>(id), timers_[id].generation});
+        }
+      }
+    }
+
+    template <typename F> void fire_slot(slot& s, F& on_expired)
+    {
+      if (s.empty())
+      {
+        return;
+      }
+      slot pending;
+      pending.swap(s);
+      for (const auto& e : pending)
+      {
+        if (!is_live(e))
+        {
+          continue;
+        }
+        if (timers_[e.id].deadline_tick > current_)
+        {
+          file(e);
+          continue;
+        }
+        timers_[e.id].active = false;
+        --active_;
+        on_expired(e.id);
+      }
+      // Keep the slot's capacity around for the next lap.
+      if (s.empty())
+      {
+        pending.clear();
+        s.swap(pending);
+      }
+    }
+  };
+} // namespace utils